@@ -1,7 +1,26 @@
 #define	TRUE	1
 #define	FALSE	0
 #define	MAXLINE	100
+#ifdef	ADAPTIVE_EPS
+/*
+The scale factor is then the largest divisor of epsilon; see
+update_epsilon.c.
+*/
+#define	DEFAULT_SCALE_FACTOR	64
+#define	ADAPT_START	10	/* first divisor */
+#define	ADAPT_MIN	2	/* smallest divisor */
+#define	ADAPT_TARGET	4.0	/* extra relabelings per node to aim at */
+#else
 #define	DEFAULT_SCALE_FACTOR	10
+#endif
+#ifdef	INIT_MATCH
+#define	INIT_DIVISOR	100.0	/* largest cost over first epsilon */
+#define	INIT_ROUNDS	3	/* of greedy proposals or auction bids */
+#endif
+#ifdef	AUCTION
+#define	AUCTION_TAIL	256	/* rhs nodes per free lhs node at most, */
+				/* before reverse bids start */
+#endif
 #define	DEFAULT_PO_COST_THRESH	(2.0 * sqrt((double) n) * \
 				 sqrt(sqrt((double) n)))
 #define	DEFAULT_PO_WORK_THRESH	50
@@ -27,7 +46,43 @@
 #define	MAGIC_MARKER	0xAAAAAAAA
 #endif
 
-#ifdef	QUEUE_ORDER
+#if	defined(WORK_STEALING)
+#define	ACTIVE_TYPE	wsset
+#define	create_active(size)	active = ws_create(size)
+#define	make_active(v)		ws_push(active, v)
+/*
+Sets v to NULL once every thread has run out of work.
+*/
+#define	get_active_node(v)	v = ws_get(active)
+extern	wsset	ws_create();
+extern	void	ws_push();
+extern	lhs_ptr	ws_get();
+#elif	defined(PAR_REFINE)
+#define	ACTIVE_TYPE	tstack
+#define	create_active(size)	active = ts_create()
+#define	make_active(v)		ts_push(active, v)
+#define	get_active_node(v)	v = ts_pop(active)
+extern	tstack	ts_create();
+extern	void	ts_push();
+extern	lhs_ptr	ts_pop();
+#elif	defined(KEYED_ORDER)
+#define	ACTIVE_TYPE	keyed
+#define	create_active(size)	active = ka_create(size)
+#define	make_active(v)		ka_insert(active, v, 0)
+#define	get_active_node(v)	v = ka_remove(active)
+#ifdef	PRICE_ORDER
+/*
+Activate v, whose former mate's price just dropped by drop. The
+bucket is the binary order of magnitude of the drop in units of
+epsilon.
+*/
+#define	make_active_dropped(v, drop) \
+	ka_insert(active, v, (unsigned) ilogb((drop) / epsilon))
+#endif
+extern	keyed	ka_create();
+extern	void	ka_insert();
+extern	lhs_ptr	ka_remove();
+#elif	defined(QUEUE_ORDER)
 #define	ACTIVE_TYPE	queue
 #define	create_active(size)	active = q_create(size)
 #define	make_active(v)		enq(active, (char *) v)
@@ -39,6 +94,37 @@
 #define	get_active_node(v)	v = (lhs_ptr) st_pop(active)
 #endif
 
+#ifndef	make_active_dropped
+#define	make_active_dropped(v, drop)	make_active(v)
+#endif
+
+#ifdef	ANYTIME
+/*
+Whether the refine under way should be given up on; the clock is read
+only once every ANYTIME_CHECK calls. See anytime.c.
+*/
+#define	anytime_out() \
+	((++anytime_ticks % ANYTIME_CHECK == 0) && anytime_expired())
+extern	unsigned	anytime_ticks;
+extern	int		anytime_expired();
+#endif
+
+/*
+Bookkeeping counters updated during parallel phases are thread-local;
+each thread's counts are added to the main thread's at the end of the
+phase.
+*/
+#ifdef	USE_THREADS
+#define	PAR_LOCAL	__thread
+/*
+passes split among threads hand out this many consecutive items at a
+time; see par_claim().
+*/
+#define	PAR_CHUNK	256
+#else
+#define	PAR_LOCAL
+#endif
+
 #define	st_push(s, el) \
 {\
 *(s->top) = (char *) el;\
@@ -80,7 +166,7 @@ memcpy() because they're so small. But the set of fields an arc has
 depends on lots of things, hence this mess.
 */
 
-#if	defined(USE_PRICE_OUT) || defined(ROUND_COSTS)
+#if	defined(USE_PRICE_OUT) || defined(ROUND_COSTS) || defined(INCREMENTAL)
 #ifdef	STORE_REV_ARCS
 #ifdef	ROUND_COSTS
 #define	copy_lr_arc(a, b) \
@@ -107,12 +193,22 @@ b->rev = a->rev;\
 	{ b->tail = a->tail; b->rev = a->rev; }
 #endif	/* USE_P_UPDATE */
 
+#ifdef	USE_THREADS
+#define	exch_rl_arcs(a, b) \
+{\
+struct	rl_arc	ex_tmp, *ex_t = &ex_tmp;\
+copy_rl_arc(b, ex_t);\
+copy_rl_arc(a, b);\
+copy_rl_arc(ex_t, a);\
+}
+#else
 #define	exch_rl_arcs(a, b) \
 {\
 copy_rl_arc(b, tail_rl_arc);\
 copy_rl_arc(a, b);\
 copy_rl_arc(tail_rl_arc, a);\
 }
+#endif
 #else	/* STORE_REV_ARCS */
 #ifdef	PREC_COSTS
 #define	copy_lr_arc(a, b) \
@@ -130,12 +226,26 @@ b->c = a->c;\
 #endif	/* PREC_COSTS */
 #endif	/* STORE_REV_ARCS */
 
+#ifdef	USE_THREADS
+/*
+Several threads may exchange arcs at once, so each exchange needs a
+temporary of its own instead of the spare arc at the end of the array.
+*/
+#define	exch_lr_arcs(a, b) \
+{\
+struct	lr_arc	ex_tmp, *ex_t = &ex_tmp;\
+copy_lr_arc(b, ex_t);\
+copy_lr_arc(a, b);\
+copy_lr_arc(ex_t, a);\
+}
+#else
 #define	exch_lr_arcs(a, b) \
 {\
 copy_lr_arc(b, tail_lr_arc);\
 copy_lr_arc(a, b);\
 copy_lr_arc(tail_lr_arc, a);\
 }
+#endif
 
 extern	lr_aptr	tail_lr_arc;
 #ifdef	STORE_REV_ARCS
@@ -143,7 +253,14 @@ extern	rl_aptr	tail_rl_arc;
 #endif
 
 #ifdef	STORE_REV_ARCS
-#define	price_in_rev(a) \
+/*
+The do_ forms are there so update_epsilon() can defer the work in the
+PAR_UPDATE_EPS case.
+*/
+#define	price_in_rev(a)		do_price_in_rev(a)
+#define	price_out_rev(a)	do_price_out_rev(a)
+
+#define	do_price_in_rev(a) \
 { \
 register	rl_aptr	b_a = --a->head->back_arcs; \
 register	rl_aptr	a_r = a->rev; \
@@ -156,7 +273,7 @@ if (b_a != a_r) \
   } \
 }
 
-#define	price_out_rev(a) \
+#define	do_price_out_rev(a) \
 { \
 register	rl_aptr	b_a = a->head->back_arcs; \
 register	rl_aptr	a_r = a->rev; \
@@ -171,6 +288,26 @@ a->head->back_arcs++; \
 }
 
 #define	handle_rev_pointers(a, b)	{ a->rev->rev = b; b->rev->rev = a; }
+
+#if	defined(PAR_UPDATE_EPS) || defined(PAR_CHECK_PO)
+/*
+Note in rev_op[] that the reverse arc of the lhs arc in slot a must
+move as the code says, just before the arcs in slots a and s of an
+lhs node's list are exchanged, exchanging their notes too; see par.c.
+*/
+#define	REV_IN		1
+#define	REV_OUT		2
+
+#define	defer_rev(a, s, code) \
+{ \
+register	char	dr_t = rev_op[a - head_lr_arc]; \
+rev_op[a - head_lr_arc] = rev_op[s - head_lr_arc]; \
+rev_op[s - head_lr_arc] = dr_t | (code); \
+}
+
+extern	char	*rev_op;
+extern	lr_aptr	head_lr_arc;
+#endif
 #else	/* STORE_REV_ARCS */
 #define	price_in_rev(a)		/* do nothing */
 #define	price_out_rev(a)	/* do nothing */
@@ -226,4 +363,29 @@ if (f_a != a) \
   exch_lr_arcs(a, f_a); \
   } \
 }
-#endif	/* USE_PRICE_OUT || ROUND_COSTS */
+#endif	/* USE_PRICE_OUT || ROUND_COSTS || INCREMENTAL */
+
+#ifdef	DEGREE_KERNELS
+/*
+Recompute v's degree class after price-ins or price-outs may have
+changed its priced-in degree, counting the moves between classes if
+we're keeping statistics.
+*/
+#define	deg_class_of(v) \
+	((v+1)->priced_out - v->first > MAX_KERNEL_DEG ? \
+	 MAX_KERNEL_DEG + 1 : (v+1)->priced_out - v->first)
+
+#ifdef	DEGREE_STATS
+#define	set_deg_class(v) \
+{ \
+register	unsigned	s_d_c = deg_class_of(v); \
+if (s_d_c != v->node_info.deg_class) \
+  { \
+  deg_moves++; \
+  v->node_info.deg_class = s_d_c; \
+  } \
+}
+#else	/* DEGREE_STATS */
+#define	set_deg_class(v)	v->node_info.deg_class = deg_class_of(v)
+#endif	/* DEGREE_STATS */
+#endif	/* DEGREE_KERNELS */
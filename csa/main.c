@@ -44,7 +44,7 @@ rl_aptr	head_rl_arc, tail_rl_arc;
 #endif
 
 /* ------------------- Bookkeeping/profiling variables ----------------- */
-unsigned	double_pushes = 0,
+PAR_LOCAL unsigned	double_pushes = 0,
 		pushes = 0,
 		relabelings = 0,
 		refines = 0,
@@ -58,6 +58,9 @@ unsigned	p_refines = 0,
 unsigned	p_updates = 0,
 		u_scans = 0,
 		p_update_time = 0;
+#ifdef	PAR_P_UPDATE
+double		p_update_secs = 0.0;
+#endif
 #endif
 #ifdef	USE_SP_AUG
 unsigned	sp_augs = 0,
@@ -68,10 +71,43 @@ unsigned	sp_augs = 0,
 unsigned	fix_ins = 0;
 #endif
 #ifdef	QUICK_MIN
-unsigned	rebuilds = 0,
+PAR_LOCAL unsigned	rebuilds = 0,
 		scans = 0,
 		non_scans = 0;
 #endif
+#ifdef	PAR_REFINE
+unsigned	par_retries = 0;
+#endif
+#ifdef	DET_PAR_REFINE
+unsigned	det_rounds = 0,
+		det_conflicts = 0;
+#endif
+#ifdef	BATCH_REFINE
+unsigned	batches = 0,
+		batch_conflicts = 0;
+#endif
+#ifdef	PIPELINE_EPS
+/*
+double pushes that displaced a node in a block not yet being refined,
+those of them that had to wait for the node's block to be updated and
+the time they waited, and the time the refining and updating threads
+spent waiting for each other otherwise.
+*/
+unsigned	pipe_crossings = 0,
+		pipe_syncs = 0;
+double		pipe_sync_time = 0.0,
+		pipe_refine_idle = 0.0,
+		pipe_update_idle = 0.0;
+#endif
+#ifdef	DEGREE_STATS
+/*
+double pushes and time spent in them, indexed by degree class, and
+number of times a node changed degree class.
+*/
+unsigned	deg_calls[MAX_KERNEL_DEG + 2],
+		deg_moves = 0;
+double		deg_time[MAX_KERNEL_DEG + 2];
+#endif
 
 /* ------------------------- Tunable variables ------------------------- */
 /*
@@ -82,6 +118,14 @@ code better.
 */
 double		po_cost_thresh;
 double		scale_factor;	/* scaling factor */
+#ifdef	ANYTIME
+double		time_limit;	/* seconds to scaling's end; 0 for none */
+double		gap_limit;	/* distance from optimal good enough */
+#endif
+#ifdef	USE_THREADS
+extern	unsigned	num_threads;	/* threads in parallel phases */
+extern	unsigned	par_default_threads();
+#endif
 #ifdef	USE_P_UPDATE
 WORK_TYPE	upd_work_thresh;/* work threshhold for global update */
 #endif
@@ -128,8 +172,17 @@ char	*name;
 {
 void	exit();
 
-(void) printf("Usage: %s [ scale [ update thresh [ price out thresh ] ] ]\n",
+#ifdef	USE_THREADS
+(void) printf("Usage: %s [ scale [ update thresh [ price out thresh ] ] ] [ threads ]",
+	      name);
+#else
+(void) printf("Usage: %s [ scale [ update thresh [ price out thresh ] ] ]",
 	      name);
+#endif
+#ifdef	ANYTIME
+(void) printf(" [ time limit [ gap limit ] ]");
+#endif
+(void) putchar('\n');
 exit(1);
 }
 
@@ -179,7 +232,7 @@ if (argc > 1)
   double	po_fac;
 
   if (sscanf(argv[1], "%lg", &po_fac) == 0) show_usage(cmd);
-  argv--; argv++;
+  argc--; argv++;
   po_work_thresh = (unsigned) (po_fac * (double) n);
   }
 else
@@ -187,6 +240,34 @@ else
 #else
 po_cost_thresh = 2.0 * (double) n * (scale_factor + 1);
 #endif
+
+#ifdef	USE_THREADS
+if (argc > 1)
+  {
+  if ((sscanf(argv[1], "%u", &num_threads) == 0) || (num_threads == 0))
+    show_usage(cmd);
+  argc--; argv++;
+  }
+else
+  num_threads = par_default_threads();
+#endif
+
+#ifdef	ANYTIME
+if (argc > 1)
+  {
+  if (sscanf(argv[1], "%lg", &time_limit) == 0) show_usage(cmd);
+  argc--; argv++;
+  }
+else
+  time_limit = 0.0;
+if (argc > 1)
+  {
+  if (sscanf(argv[1], "%lg", &gap_limit) == 0) show_usage(cmd);
+  argc--; argv++;
+  }
+else
+  gap_limit = 0.0;
+#endif
 }
 
 void	describe_self()
@@ -228,7 +309,13 @@ desc[i++] = "Reverse arcs";
 #ifdef	USE_P_REFINE
 desc[i++] = "Price refinement";
 #endif
-#ifdef	QUEUE_ORDER
+#if	defined(WAVE_ORDER)
+desc[i++] = "Wave ordering";
+#elif	defined(PRICE_ORDER)
+desc[i++] = "Price-drop ordering";
+#elif	defined(LOCALITY_ORDER)
+desc[i++] = "Locality ordering";
+#elif	defined(QUEUE_ORDER)
 desc[i++] = "Queue ordering";
 #else
 desc[i++] = "Stack ordering";
@@ -237,6 +324,68 @@ desc[i++] = "Stack ordering";
 (void) sprintf(minstr, "Quick minima; NUM_BEST = %d", NUM_BEST);
 desc[i++] = minstr;
 #endif
+#ifdef	DEGREE_KERNELS
+desc[i++] = "Degree kernels";
+#endif
+#ifdef	BATCH_REFINE
+desc[i++] = "Batched double pushes";
+#endif
+#ifdef	PAR_REFINE
+desc[i++] = "Parallel refine";
+#endif
+#ifdef	WORK_STEALING
+desc[i++] = "Work stealing";
+#endif
+#ifdef	DET_PAR_REFINE
+desc[i++] = "Deterministic parallel refine";
+#endif
+#ifdef	PIPELINE_EPS
+desc[i++] = "Pipelined phases";
+#endif
+#ifdef	COMPONENTS
+desc[i++] = "Components";
+#endif
+#ifdef	AUTO_TUNE
+desc[i++] = "Auto-tuned";
+#endif
+#ifdef	BATCH_MODE
+desc[i++] = "Batch";
+#endif
+#ifdef	WARM_START
+desc[i++] = "Warm start";
+#endif
+#ifdef	DYNAMIC_NODES
+desc[i++] = "Dynamic nodes";
+#elif	defined(INCREMENTAL)
+desc[i++] = "Incremental";
+#endif
+#ifdef	CAPACITY
+desc[i++] = "Capacitated";
+#endif
+#ifdef	IMPERFECT
+desc[i++] = "Imperfect matching";
+#elif	defined(RECT_ASSIGN) && !defined(CAPACITY)
+desc[i++] = "Rectangular";
+#endif
+#ifdef	ANYTIME
+desc[i++] = "Anytime";
+#endif
+#ifdef	ADAPTIVE_EPS
+desc[i++] = "Adaptive epsilon";
+#endif
+#if	defined(INIT_GREEDY)
+desc[i++] = "Greedy initialization";
+#elif	defined(INIT_AUCTION)
+desc[i++] = "Auction initialization";
+#elif	defined(INIT_DUAL)
+desc[i++] = "Dual ascent initialization";
+#endif
+#ifdef	AUCTION
+desc[i++] = "Forward-reverse auction";
+#endif
+#ifdef	DENSE_JV
+desc[i++] = "Dense JV";
+#endif
 
 desc[i] = NULL;
 
@@ -252,6 +401,27 @@ for (i = 5; i > 0; i--)
 (void) putchar('\n');
 }
 
+#ifdef	PAR_BEST_BUILD
+/*
+Build the best lists of the lhs nodes thread id owns.
+*/
+
+static	void	build_thread(id)
+
+unsigned	id;
+
+{
+lhs_ptr	v, v_stop;
+extern	lhs_ptr	par_own_lhs();
+extern	void	par_fold_counts(), best_build();
+
+for (v = par_own_lhs(id, &v_stop); v != v_stop; v++)
+  if (!v->node_info.few_arcs)
+    best_build(v);
+par_fold_counts(id);
+}
+#endif
+
 void	init(argc, argv)
 
 unsigned	argc;
@@ -274,26 +444,101 @@ rhs_ptr	r_v;
 long	i;
 #endif
 #ifdef	QUICK_MIN
+#ifdef	PAR_BEST_BUILD
+void	par_run();
+#else
 lhs_ptr	l_v;
 void	best_build();
 #endif
+#endif
+#ifdef	AUTO_TUNE
+void	auto_tune();
+#endif
+#ifdef	WARM_START
+double	warm_start();
+#endif
+#ifdef	INIT_MATCH
+double	init_match();
+#endif
+#ifdef	DENSE_JV
+int	jv_choose();
+#endif
+#ifdef	BATCH_MODE
+static	unsigned	room = 0;	/* nodes the active set holds */
+#if	defined(USE_P_REFINE) || defined(USE_P_UPDATE) || defined(USE_SP_AUG)
+static	long		bucket_room = 0;
+#endif
+#endif
 
+/*
+In the AUTO_TUNE case, auto_tune() describes the program once it's
+sure not to hand the input to another variant.
+*/
+#ifndef	AUTO_TUNE
 describe_self();
+#endif
 
 epsilon = parse();
 parse_cmdline(argc, argv);
+#ifdef	AUTO_TUNE
+auto_tune(argc, argv);
+#endif
+#ifdef	WARM_START
+epsilon = warm_start(epsilon);
+#endif
+#ifdef	INIT_MATCH
+epsilon = init_match(epsilon);
+#endif
+#ifdef	DENSE_JV
+/*
+The dense path needs none of what follows.
+*/
+if (jv_choose(epsilon))
+  return;
+#endif
 
+#ifdef	BATCH_MODE
+/*
+Keep the active set and the buckets of the last instance unless this
+one needs more room.
+*/
+if (n > room)
+  {
+  if (room > 0)
+    {
+    (void) free((char *) active->bottom);
+    (void) free((char *) active);
+#ifdef	USE_P_REFINE
+    (void) free((char *) reached_nodes->bottom);
+    (void) free((char *) reached_nodes);
+#endif
+    }
+  room = n;
+#endif
 create_active(n);
 #ifdef	USE_P_REFINE
 reached_nodes = st_create(n);
 #endif
+#ifdef	BATCH_MODE
+  }
+#endif
 #if	defined(USE_P_REFINE) || defined(USE_P_UPDATE) || defined(USE_SP_AUG)
 #ifdef	PREC_COSTS
 num_buckets = scale_factor * n + 1;
 #else
 num_buckets = 2 * scale_factor * n + 1;
 #endif
+#ifdef	BATCH_MODE
+if (num_buckets > bucket_room)
+  {
+  if (bucket_room > 0)
+    (void) free((char *) bucket);
+  bucket = (rhs_ptr *) malloc((unsigned) num_buckets * sizeof(rhs_ptr));
+  bucket_room = bucket ? num_buckets : 0;
+  }
+#else
 bucket = (rhs_ptr *) malloc((unsigned) num_buckets * sizeof(rhs_ptr));
+#endif
 if (bucket == NULL)
   {
   (void) printf("Insufficient memory.\n");
@@ -305,9 +550,13 @@ for (r_v = head_rhs_node; r_v != tail_rhs_node; r_v++)
   r_v->key = num_buckets;
 #endif
 #ifdef	QUICK_MIN
+#ifdef	PAR_BEST_BUILD
+par_run(build_thread);
+#else
 for (l_v = head_lhs_node; l_v != tail_lhs_node; l_v++)
   if (!l_v->node_info.few_arcs)
     best_build(l_v);
+#endif
 /*
 Count only those builds that take place after initialization; first
 setup is free.
@@ -340,12 +589,114 @@ unsigned	time;
 {
 #ifdef	SAVE_RESULT
 lhs_ptr	v;
+#ifdef	BATCH_MODE
+extern	FILE	*batch_flow;
+FILE	*f = batch_flow;
+#else
 FILE	*f;
-double	edge_cost;
+#endif
+#ifndef	DYNAMIC_NODES
+extern	unsigned	in_id_offset;
+extern	int		in_swap;
+#endif
+#ifdef	COMPONENTS
+extern	unsigned	*lhs_pos, *rhs_id;
+#endif
+#endif
+#if	defined(DEGREE_STATS) || defined(WORK_STEALING) || \
+	(defined(SAVE_RESULT) && defined(COMPONENTS))
+unsigned	i;
+#endif
+#ifdef	COMPONENTS
+void	display_components();
+unsigned	comp_solve_time();
+#endif
+#ifdef	WARM_START
+void	display_warm(), write_dual();
+#endif
+#ifdef	INCREMENTAL
+void	display_incr();
+#endif
+#ifdef	DYNAMIC_NODES
+unsigned long	dyn_lhs_id(), dyn_rhs_id();
+#endif
+#ifdef	RECT_ASSIGN
+void	display_rect();
+#endif
+#ifdef	ANYTIME
+void	display_anytime();
+#endif
+#ifdef	ADAPTIVE_EPS
+void	display_adapt();
+#endif
+#ifdef	INIT_MATCH
+void	display_init();
+#endif
+#ifdef	AUCTION
+void	display_auction();
+#endif
+#ifdef	DENSE_JV
+void	display_jv();
 #endif
 
 (void) printf("|>   cost %17.0f,    time %10.3f seconds\n",
 	      compute_cost(), (double) time / 60.0);
+#if	defined(USE_THREADS) && !defined(BATCH_MODE)
+(void) printf("|>   %u threads\n", num_threads);
+#endif
+#ifdef	COMPONENTS
+display_components();
+#endif
+#ifdef	WARM_START
+display_warm();
+#endif
+#ifdef	INCREMENTAL
+display_incr();
+#endif
+#ifdef	RECT_ASSIGN
+display_rect();
+#endif
+#ifdef	ANYTIME
+display_anytime();
+#endif
+#ifdef	ADAPTIVE_EPS
+display_adapt();
+#endif
+#ifdef	INIT_MATCH
+display_init();
+#endif
+#ifdef	AUCTION
+display_auction();
+#endif
+#ifdef	DENSE_JV
+display_jv();
+#endif
+#ifdef	PAR_REFINE
+(void) printf("|>   %u lost races for rhs nodes\n", par_retries);
+#endif
+#ifdef	DET_PAR_REFINE
+(void) printf("|>   %u rounds of double pushes, %u conflicts\n",
+	      det_rounds, det_conflicts);
+#endif
+#ifdef	PIPELINE_EPS
+(void) printf("|>   %u cross-block double pushes, %u waited %.3f seconds\n",
+	      pipe_crossings, pipe_syncs, pipe_sync_time);
+(void) printf("|>   idle between blocks: refine %.3f, update %.3f seconds\n",
+	      pipe_refine_idle, pipe_update_idle);
+#endif
+#ifdef	WORK_STEALING
+for (i = 0; i < num_threads; i++)
+  (void) printf("|>     thread %u: %u steals in %u tries, %.3f seconds idle\n",
+		i, active->dq[i].steals, active->dq[i].steal_tries,
+		active->dq[i].idle_time);
+#endif
+#ifdef	COMPONENTS
+/*
+The counts are summed over components solved at the same time, so the
+phase percentages are of the summed solve time, not the elapsed time.
+*/
+time = comp_solve_time();
+#endif
 /*
 Avoid division by zero.
 */
@@ -364,6 +715,10 @@ if (time == 0) time = 1;
 (void) printf("|>   %u p_updates: %lg%%      %u u_scans\n",
 	      p_updates, 100.0 * (double) p_update_time / (double) time,
 	      u_scans);
+#ifdef	PAR_P_UPDATE
+(void) printf("|>                   %lg u_scans per second\n",
+	      p_update_secs > 0.0 ? (double) u_scans / p_update_secs : 0.0);
+#endif
 #endif
 #ifdef	USE_SP_AUG
 (void) printf("|>   %u sp_augs:   %lg%%      %u a_scans\n",
@@ -377,52 +732,114 @@ if (time == 0) time = 1;
 (void) printf("|>   %u list rebuilds, %u full scans, %u avoided scans\n",
 	      rebuilds, scans, non_scans);
 #endif
+#ifdef	BATCH_REFINE
+(void) printf("|>   %u batches of up to %d double pushes, %u conflicts\n",
+	      batches, BATCH_SIZE, batch_conflicts);
+#endif
+#ifdef	DEGREE_STATS
+for (i = 1; i <= MAX_KERNEL_DEG + 1; i++)
+  (void) printf("|>   degree %s%u: %10u calls, %10.3f seconds\n",
+		i > MAX_KERNEL_DEG ? ">" : " ",
+		i > MAX_KERNEL_DEG ? MAX_KERNEL_DEG : i,
+		deg_calls[i], deg_time[i]);
+(void) printf("|>   %u degree class changes\n", deg_moves);
+#endif
 (void) puts(banner);
+#ifdef	WARM_START
+write_dual();
+#endif
 #ifdef	SAVE_RESULT
+#ifndef	BATCH_MODE
 f = fopen("output.flow", "w");
+#endif
+#ifdef	COMPONENTS
+/*
+Write the matching in input order, with input node numbers. If parse()
+swapped the sides, each pair is written input lhs node first.
+*/
+for (i = 0; i < tail_lhs_node - head_lhs_node; i++)
+  {
+  double	edge_cost;
+
+  v = head_lhs_node + lhs_pos[i];
+  edge_cost = -v->matched->c;
+  if (in_swap)
+    (void) fprintf(f, "f %u %u %.0lf\n",
+		   rhs_id[v->matched->head - head_rhs_node] + 1,
+		   i + 1 + in_id_offset, edge_cost);
+  else
+    (void) fprintf(f, "f %u %u %.0lf\n", i + 1,
+		   rhs_id[v->matched->head - head_rhs_node] + 1 +
+		   in_id_offset, edge_cost);
+  }
+#elif	defined(DYNAMIC_NODES)
+/*
+Write the matching with the node numbers the stream uses, skipping
+slots not in use.
+*/
+for (v = head_lhs_node; v != tail_lhs_node; v++)
+  if (v->matched)
+    (void) fprintf(f, "f %lu %lu %.0lf\n", dyn_lhs_id(v),
+		   dyn_rhs_id(v->matched->head), -v->matched->c);
+#else
 for (v = head_lhs_node; v != tail_lhs_node; v++)
   {
+  double	edge_cost;
+
+#ifdef	IMPERFECT
+  if (v->matched == NULL)
+    continue;
+#endif
 #ifdef	ROUND_COSTS
   edge_cost = -v->matched->c_init;
 #else
   edge_cost = -v->matched->c;
 #endif
-  (void) fprintf(f, "f %lu %lu %.0lf\n",
-		 v - head_lhs_node + 1,
-		 v->matched->head - head_rhs_node + 1 +
-		 tail_lhs_node - head_lhs_node,
-		 edge_cost);
+  if (in_swap)
+    (void) fprintf(f, "f %lu %lu %.0lf\n",
+		   v->matched->head - head_rhs_node + 1,
+		   v - head_lhs_node + 1 + in_id_offset,
+		   edge_cost);
+  else
+    (void) fprintf(f, "f %lu %lu %.0lf\n",
+		   v - head_lhs_node + 1,
+		   v->matched->head - head_rhs_node + 1 + in_id_offset,
+		   edge_cost);
   }
+#endif
+#ifndef	BATCH_MODE
 (void) fclose(f);
 #endif
+#endif
 }
 
-int	main(argc, argv)
+/*
+Scale epsilon down from its present value to min_epsilon, refining at
+each step. start is the time the solution began.
+*/
 
-int     argc;
-char		*argv[];
+void	cost_scaling(start)
+
+unsigned	start;
 
 {
-unsigned	time, myclock();
 extern	int	update_epsilon();
 extern	void	refine();
 extern	int	p_refine();
-
-init(argc, argv);
-
-(void) printf("|>  n = %u,  m = %u,  sc_f = %lg", n, m, scale_factor);
-#if	defined(USE_PRICE_OUT) || defined(ROUND_COSTS)
-(void) printf(",  po_thr = %lg", po_cost_thresh);
+#ifdef	VERBOSE_TIME
+unsigned	myclock();
 #endif
-(void) putchar('\n');
+#ifdef	ANYTIME
+extern	void	anytime_start();
+extern	int	anytime_done();
 
-#ifdef	PREC_COSTS
-min_epsilon = 2.0 / (double) (n + 1);
-#else
-min_epsilon = 1.0 / (double) (n + 1);
+anytime_start();
 #endif
+#ifdef	ADAPTIVE_EPS
+extern	void	adapt_reset();
 
-time = myclock();
+adapt_reset();
+#endif
 
 #ifdef	USE_P_REFINE
 (void) update_epsilon();
@@ -433,7 +850,7 @@ while (epsilon > min_epsilon)
   {
 #ifdef	VERBOSE_TIME
   (void) printf("|>   Epsilon = %lg; time = %lg\n",
-		epsilon, ((double) (myclock() - time)) / 60.0);
+		epsilon, ((double) (myclock() - start)) / 60.0);
 #endif
 #ifdef	USE_P_REFINE
   if (!update_epsilon() || !p_refine())
@@ -441,11 +858,83 @@ while (epsilon > min_epsilon)
 #else
   (void) update_epsilon();
   refine();
+#endif
+#ifdef	ANYTIME
+  if (anytime_done())
+    break;
 #endif
   }
+}
+
+/*
+Read, solve and report on one instance.
+*/
+
+void	solve(argc, argv)
+
+int	argc;
+char	*argv[];
+
+{
+unsigned	time, myclock();
+#ifdef	COMPONENTS
+void	solve_components();
+#endif
+#ifdef	INCREMENTAL
+void	incr_stream();
+#endif
+#ifdef	DENSE_JV
+extern	int	dense_jv;
+void	jv_solve();
+#endif
+
+init(argc, argv);
+
+(void) printf("|>  n = %u,  m = %u,  sc_f = %lg", n, m, scale_factor);
+#if	defined(USE_PRICE_OUT) || defined(ROUND_COSTS)
+(void) printf(",  po_thr = %lg", po_cost_thresh);
+#endif
+(void) putchar('\n');
+
+#ifdef	PREC_COSTS
+min_epsilon = 2.0 / (double) (n + 1);
+#else
+min_epsilon = 1.0 / (double) (n + 1);
+#endif
+
+time = myclock();
+
+#ifdef	COMPONENTS
+solve_components();
+#elif	defined(DENSE_JV)
+if (dense_jv)
+  jv_solve();
+else
+  cost_scaling(time);
+#else
+cost_scaling(time);
+#endif
 
 time = myclock() - time;
 
 display_results(time);
+#ifdef	INCREMENTAL
+incr_stream();
+#endif
+}
+
+int	main(argc, argv)
+
+int     argc;
+char		*argv[];
+
+{
+#ifdef	BATCH_MODE
+void	solve_batch();
+
+solve_batch(argc, argv);
+#else
+solve(argc, argv);
+#endif
 return(0);
 }
@@ -0,0 +1,585 @@
+#include	<stdio.h>
+#include	<stdlib.h>
+#include	<unistd.h>
+#include	<pthread.h>
+#include	<sched.h>
+#include	"csa_types.h"
+#include	"csa_defs.h"
+
+/*
+Support for the multi-threaded variants: a way to run a function on
+num_threads threads at once, and a lock-free stack of lhs nodes for
+use as a shared active set.
+*/
+
+unsigned	num_threads;	/* number of threads in parallel phases */
+PAR_LOCAL unsigned	par_self;	/* this thread's id */
+static	int	par_phase = FALSE;	/* in a parallel phase? */
+static	unsigned	par_next;	/* next node to be claimed */
+#if	defined(QUICK_MIN) && (defined(PAR_UPDATE_EPS) || \
+	defined(PAR_CHECK_PO) || defined(PAR_P_UPDATE) || \
+	defined(PAR_BEST_BUILD) || defined(PIPELINE_EPS))
+extern	PAR_LOCAL unsigned	rebuilds;
+static	unsigned	*main_rebuilds;	/* the calling thread's count */
+#endif
+
+#ifdef	DET_PAR_REFINE
+static	pthread_barrier_t	par_bar;
+#endif
+
+extern	char	*nomem_msg;
+
+typedef	struct	par_job	{
+			void		(*fn)();
+			unsigned	id;
+			}	par_job;
+
+unsigned	par_default_threads()
+
+{
+long	cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+return(cpus > 0 ? (unsigned) cpus : 1);
+}
+
+static	void	*par_start(arg)
+
+void	*arg;
+
+{
+par_job	*job = (par_job *) arg;
+
+par_self = job->id;
+(*job->fn)(job->id);
+return(NULL);
+}
+
+/*
+Call fn(id) for id = 0, ..., num_threads - 1 concurrently, and return
+when all the calls have returned. The call with id 0 runs on the
+calling thread, so thread-local variables seen by fn(0) are the
+caller's own.
+*/
+
+void	par_run(fn)
+
+void	(*fn)();
+
+{
+static	pthread_t	*thread = NULL;
+static	par_job		*job;
+unsigned	i;
+void	exit();
+
+if (thread == NULL)
+  {
+  thread = (pthread_t *) malloc(num_threads * sizeof(pthread_t));
+  job = (par_job *) malloc(num_threads * sizeof(par_job));
+  if ((thread == NULL) || (job == NULL))
+    {
+    (void) printf("%s", nomem_msg);
+    exit(9);
+    }
+#ifdef	DET_PAR_REFINE
+  (void) pthread_barrier_init(&par_bar, NULL, num_threads);
+#endif
+  }
+par_phase = TRUE;
+par_next = 0;
+#if	defined(QUICK_MIN) && (defined(PAR_UPDATE_EPS) || \
+	defined(PAR_CHECK_PO) || defined(PAR_P_UPDATE) || \
+	defined(PAR_BEST_BUILD) || defined(PIPELINE_EPS))
+main_rebuilds = &rebuilds;
+#endif
+for (i = 1; i < num_threads; i++)
+  {
+  job[i].fn = fn;
+  job[i].id = i;
+  if (pthread_create(&thread[i], NULL, par_start, (void *) &job[i]))
+    {
+    (void) printf("Can't create thread.\n");
+    exit(9);
+    }
+  }
+(*fn)(0);
+for (i = 1; i < num_threads; i++)
+  (void) pthread_join(thread[i], NULL);
+par_phase = FALSE;
+}
+
+#ifdef	DET_PAR_REFINE
+/*
+Wait until every thread in the current parallel phase has called
+par_barrier().
+*/
+
+void	par_barrier()
+
+{
+(void) pthread_barrier_wait(&par_bar);
+}
+#endif
+
+#ifdef	PAR_REFINE
+/*
+Lock-free (Treiber) stack of lhs nodes linked through next_active.
+The top pointer carries a modification count that is updated with it
+in a single double-width compare-and-swap, so a node popped and pushed
+again between our read of the top and our swap can't fool us.
+*/
+
+tstack	ts_create()
+
+{
+tstack	s;
+void	exit();
+
+s = (tstack) malloc(sizeof(struct tstack_st));
+if (s == NULL)
+  {
+  (void) printf("%s", nomem_msg);
+  exit(9);
+  }
+s->head.f.top = NULL;
+s->head.f.tag = 0;
+return(s);
+}
+
+void	ts_push(s, v)
+
+tstack	s;
+lhs_ptr	v;
+
+{
+ts_head	old, new;
+
+do
+  {
+  old = s->head;
+  v->next_active = old.f.top;
+  new.f.top = v;
+  new.f.tag = old.f.tag + 1;
+  }
+while (!__sync_bool_compare_and_swap(&s->head.bits, old.bits, new.bits));
+}
+
+/*
+Pop a node, or return NULL if the stack is empty.
+*/
+
+lhs_ptr	ts_pop(s)
+
+tstack	s;
+
+{
+ts_head	old, new;
+
+do
+  {
+  old = s->head;
+  if (old.f.top == NULL)
+    return(NULL);
+  new.f.top = old.f.top->next_active;
+  new.f.tag = old.f.tag + 1;
+  }
+while (!__sync_bool_compare_and_swap(&s->head.bits, old.bits, new.bits));
+return(old.f.top);
+}
+#endif
+
+#ifdef	WORK_STEALING
+/*
+Per-thread work-stealing deques (Chase and Lev). Each thread works
+from the bottom of its own deque and, when that's empty, steals from
+the tops of the others'. Nodes activated outside a parallel phase are
+dealt out to the deques in turn. Since a thread only ever adds work
+while it's busy, the phase is over once every thread is idle at the
+same time; ws_get() keeps count of the idle threads to detect this.
+*/
+
+extern	double	fine_clock();
+
+wsset	ws_create(size)
+
+unsigned	size;
+
+{
+wsset		s;
+unsigned	i;
+unsigned long	cap;
+void	exit();
+
+for (cap = 1; cap < size; cap <<= 1) ;
+s = (wsset) malloc(sizeof(struct wsset_st));
+if (s != NULL)
+  s->dq = (wsdeque *) aligned_alloc(64, num_threads * sizeof(wsdeque));
+if ((s == NULL) || (s->dq == NULL))
+  {
+  (void) printf("%s", nomem_msg);
+  exit(9);
+  }
+s->num = num_threads;
+s->mask = cap - 1;
+s->idle = s->done = s->seed = 0;
+for (i = 0; i < num_threads; i++)
+  {
+  s->dq[i].buf = (lhs_ptr *) malloc(cap * sizeof(lhs_ptr));
+  if (s->dq[i].buf == NULL)
+    {
+    (void) printf("%s", nomem_msg);
+    exit(9);
+    }
+  s->dq[i].top = s->dq[i].bottom = 0;
+  s->dq[i].steals = s->dq[i].steal_tries = 0;
+  s->dq[i].idle_time = 0.0;
+  }
+return(s);
+}
+
+void	ws_push(s, v)
+
+wsset	s;
+lhs_ptr	v;
+
+{
+wsdeque	*d;
+long	b;
+
+if (par_phase)
+  d = &s->dq[par_self];
+else
+  {
+  d = &s->dq[s->seed];
+  if (++s->seed == s->num)
+    s->seed = 0;
+  }
+b = d->bottom;
+d->buf[b & s->mask] = v;
+__atomic_store_n(&d->bottom, b + 1, __ATOMIC_RELEASE);
+}
+
+/*
+Pop a node from the bottom of our own deque, or return NULL if it's
+empty.
+*/
+
+static	lhs_ptr	wsd_pop(s, d)
+
+wsset	s;
+wsdeque	*d;
+
+{
+long	b, t;
+lhs_ptr	v;
+
+b = d->bottom - 1;
+__atomic_store_n(&d->bottom, b, __ATOMIC_SEQ_CST);
+t = __atomic_load_n(&d->top, __ATOMIC_SEQ_CST);
+if (t > b)
+  {
+  d->bottom = b + 1;
+  return(NULL);
+  }
+v = d->buf[b & s->mask];
+if (t == b)
+  {
+  /*
+  Last node; race any thieves for it.
+  */
+  if (!__atomic_compare_exchange_n(&d->top, &t, t + 1, FALSE,
+				   __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+    v = NULL;
+  d->bottom = b + 1;
+  }
+return(v);
+}
+
+/*
+Steal a node from the top of another thread's deque. Return NULL if
+the deque is empty or another thread beat us to the node.
+*/
+
+static	lhs_ptr	wsd_steal(s, d)
+
+wsset	s;
+wsdeque	*d;
+
+{
+long	b, t;
+lhs_ptr	v;
+
+t = __atomic_load_n(&d->top, __ATOMIC_SEQ_CST);
+b = __atomic_load_n(&d->bottom, __ATOMIC_SEQ_CST);
+if (t >= b)
+  return(NULL);
+v = d->buf[t & s->mask];
+if (!__atomic_compare_exchange_n(&d->top, &t, t + 1, FALSE,
+				 __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+  return(NULL);
+return(v);
+}
+
+/*
+Return a node for this thread to work on, stealing one if our deque
+is empty, or NULL once every thread is out of work. A thread counts
+itself idle only between attempts to steal, so it can't be counted
+while it holds a stolen node.
+*/
+
+lhs_ptr	ws_get(s)
+
+wsset	s;
+
+{
+wsdeque		*d = &s->dq[par_self];
+lhs_ptr		v;
+unsigned	i, victim;
+double		idle_start;
+
+if ((v = wsd_pop(s, d)) != NULL)
+  return(v);
+idle_start = fine_clock();
+(void) __sync_fetch_and_add(&s->idle, 1);
+while (*((volatile unsigned *) &s->idle) != s->num)
+  {
+  (void) __sync_fetch_and_sub(&s->idle, 1);
+  for (i = 1, victim = par_self; i < s->num; i++)
+    {
+    if (++victim == s->num)
+      victim = 0;
+    d->steal_tries++;
+    if ((v = wsd_steal(s, &s->dq[victim])) != NULL)
+      {
+      d->steals++;
+      d->idle_time += fine_clock() - idle_start;
+      return(v);
+      }
+    }
+  (void) __sync_fetch_and_add(&s->idle, 1);
+  (void) sched_yield();
+  }
+d->idle_time += fine_clock() - idle_start;
+/*
+The last thread to finish the phase resets the counts for the next
+one; every other thread has already seen the phase end by then.
+*/
+if (__sync_add_and_fetch(&s->done, 1) == s->num)
+  s->idle = s->done = 0;
+return(NULL);
+}
+#endif
+
+#if	defined(PAR_UPDATE_EPS) || defined(PAR_CHECK_PO) || \
+	defined(PAR_P_UPDATE) || defined(PAR_BEST_BUILD) || \
+	defined(PIPELINE_EPS)
+/*
+Support for passes over all the nodes split among threads, each of
+which claims PAR_CHUNK consecutive nodes at a time.
+*/
+
+extern	lhs_ptr	head_lhs_node, tail_lhs_node;
+extern	rhs_ptr	head_rhs_node, tail_rhs_node;
+
+/*
+Claim the next run of at most PAR_CHUNK of count items in the current
+parallel phase, setting *first and *stop to its bounds, or return
+FALSE if they're all taken.
+*/
+
+int	par_claim(count, first, stop)
+
+unsigned	count, *first, *stop;
+
+{
+unsigned	i;
+
+i = __sync_fetch_and_add(&par_next, PAR_CHUNK);
+if (i >= count)
+  return(FALSE);
+*first = i;
+*stop = (count - i > PAR_CHUNK) ? i + PAR_CHUNK : count;
+return(TRUE);
+}
+
+/*
+Add the counts kept by thread id during a parallel phase to those of
+the thread that started the phase.
+*/
+
+void	par_fold_counts(id)
+
+unsigned	id;
+
+{
+#ifdef	QUICK_MIN
+if (id > 0)
+  {
+  (void) __sync_fetch_and_add(main_rebuilds, rebuilds);
+  rebuilds = 0;
+  }
+#endif
+}
+
+/*
+Claim a run of lhs nodes, setting *v_stop to its end, or return NULL
+if none are left.
+*/
+
+lhs_ptr	par_claim_lhs(v_stop)
+
+lhs_ptr	*v_stop;
+
+{
+unsigned	first, stop;
+
+if (!par_claim(tail_lhs_node - head_lhs_node, &first, &stop))
+  return(NULL);
+*v_stop = head_lhs_node + stop;
+return(head_lhs_node + first);
+}
+
+#ifdef	PAR_BEST_BUILD
+/*
+Return the first of the lhs nodes thread id owns in a statically
+split pass, setting *v_stop to the end of its run. The runs are
+contiguous and, except for the last, a multiple of PAR_CHUNK nodes
+long, so threads share cache lines only at the ends of their runs and
+the hardware prefetcher sees one long sequential sweep per thread.
+*/
+
+lhs_ptr	par_own_lhs(id, v_stop)
+
+unsigned	id;
+lhs_ptr		*v_stop;
+
+{
+unsigned	count = tail_lhs_node - head_lhs_node, per;
+
+per = (count + num_threads - 1) / num_threads;
+per = (per + PAR_CHUNK - 1) / PAR_CHUNK * PAR_CHUNK;
+if (per * id >= count)
+  {
+  *v_stop = tail_lhs_node;
+  return(tail_lhs_node);
+  }
+*v_stop = (count - per * id > per) ? head_lhs_node + per * (id + 1)
+				   : tail_lhs_node;
+return(head_lhs_node + per * id);
+}
+#endif
+
+#if	defined(STORE_REV_ARCS) && \
+	(defined(PAR_UPDATE_EPS) || defined(PAR_CHECK_PO))
+/*
+The reverse arcs into an rhs node are shared among all the lhs nodes
+adjacent to it, so a parallel pass that prices arcs in or out moves
+only the lhs arcs, noting in rev_op[] (through defer_rev()) which
+reverse arcs have to move. par_rev_moves() then makes those moves,
+splitting the rhs nodes among threads.
+*/
+
+extern	lr_aptr	head_lr_arc;
+
+char	*rev_op = NULL;
+static	unsigned	max_rhs_deg;
+
+typedef	struct	rev_pending	{
+				lhs_ptr	tail;
+				lr_aptr	a;
+				char	op;
+				}	rev_pending;
+
+void	par_rev_init()
+
+{
+extern	unsigned	m;
+rhs_ptr	w;
+void	exit();
+
+if (rev_op == NULL)
+  {
+  rev_op = (char *) calloc(m + 1, sizeof(char));
+  if (rev_op == NULL)
+    {
+    (void) printf("%s", nomem_msg);
+    exit(9);
+    }
+  max_rhs_deg = 0;
+  for (w = head_rhs_node; w != tail_rhs_node; w++)
+    if ((w+1)->priced_out - w->priced_out > max_rhs_deg)
+      max_rhs_deg = (w+1)->priced_out - w->priced_out;
+  }
+}
+
+static	int	rev_cmp(p, q)
+
+rev_pending	*p, *q;
+
+{
+if (p->tail != q->tail)
+  return(p->tail < q->tail ? -1 : 1);
+return(p->a < q->a ? -1 : (p->a > q->a));
+}
+
+/*
+Carry out the reverse-arc moves noted for the arcs into each rhs node
+claimed, in increasing order of the arcs' tails, which is the order
+the serial pass would have made them in.
+*/
+
+static	void	rev_thread(id)
+
+unsigned	id;
+
+{
+rhs_ptr		w;
+rl_aptr		b, b_stop;
+lr_aptr		a;
+rev_pending	*pend;
+unsigned	i, k, first, stop;
+void	exit();
+
+pend = (rev_pending *) malloc((max_rhs_deg + 1) * sizeof(rev_pending));
+if (pend == NULL)
+  {
+  (void) printf("%s", nomem_msg);
+  exit(9);
+  }
+while (par_claim(tail_rhs_node - head_rhs_node, &first, &stop))
+  for (w = head_rhs_node + first; w != head_rhs_node + stop; w++)
+    {
+    k = 0;
+    b_stop = (w+1)->priced_out;
+    for (b = w->priced_out; b != b_stop; b++)
+      if (rev_op[b->rev - head_lr_arc])
+	{
+	pend[k].tail = b->tail;
+	pend[k].a = b->rev;
+	pend[k++].op = rev_op[b->rev - head_lr_arc];
+	rev_op[b->rev - head_lr_arc] = 0;
+	}
+    if (k > 1)
+      qsort((char *) pend, k, sizeof(rev_pending), rev_cmp);
+    for (i = 0; i < k; i++)
+      {
+      a = pend[i].a;
+      if (pend[i].op & REV_IN)
+	{
+	do_price_in_rev(a);
+	}
+      else if (pend[i].op & REV_OUT)
+	{
+	do_price_out_rev(a);
+	}
+      }
+    }
+free((char *) pend);
+}
+
+void	par_rev_moves()
+
+{
+par_run(rev_thread);
+}
+#endif	/* STORE_REV_ARCS */
+#endif	/* PAR_UPDATE_EPS || ... || PAR_BEST_BUILD */
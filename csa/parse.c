@@ -12,6 +12,8 @@
 #define BADCOUNT	1006	/* Arc count discrepancy */
 #define	NONCONTIG	1007	/* Node id numbers not contiguous */
 #define NOMEM		1008	/* Not enough memory */
+#define	NOROOM		1009	/* Capacity short of the lhs nodes */
+#define	BADMATRIX	1010	/* Bad cost matrix */
 
 char *err_messages[] =
 {
@@ -23,6 +25,8 @@ char *err_messages[] =
 "Inconsistent number of arcs in the input.",
 "Parsing noncontiguous node ID numbers not implemented.",
 "Can't obtain enough memory to solve this problem.",
+"Total rhs capacity is less than the number of lhs nodes.",
+"Not a correct cost matrix.",
 };
 
 void parse_error(err_index)
@@ -43,6 +47,51 @@ typedef	struct	temp_arc	{
 				long	cost;
 				}	*ta_ptr;
 
+#ifdef	BATCH_MODE
+/*
+A batch worker parses one instance after another from the stream held
+in memory (see batch.c), and keeps the arrays it allocates for the
+next instance, replacing each only when an instance needs a bigger
+one.
+*/
+extern	FILE	*batch_in;
+#define	PARSE_IN	batch_in
+
+#define	LR_ARCS		0
+#define	RL_ARCS		1
+#define	LHS_NODES	2
+#define	RHS_NODES	3
+#define	LHS_DEGREES	4
+#define	RHS_DEGREES	5
+#define	TEMP_ARCS	6
+#define	NUM_BLOCKS	7
+
+static	char	*parse_alloc(which, size)
+
+int		which;
+unsigned long	size;
+
+{
+static	char		*block[NUM_BLOCKS];
+static	unsigned long	room[NUM_BLOCKS];
+
+if (size > room[which])
+  {
+  if (block[which])
+    (void) free(block[which]);
+  block[which] = (char *) malloc(size);
+  room[which] = block[which] ? size : 0;
+  }
+return(block[which]);
+}
+
+#define	parse_free(p)
+#else
+#define	PARSE_IN	stdin
+#define	parse_alloc(which, size)	malloc(size)
+#define	parse_free(p)	(void) free((char *) p)
+#endif
+
 extern	char	*banner;
 extern	unsigned	m, n;
 extern	lhs_ptr	head_lhs_node, tail_lhs_node;
@@ -52,6 +101,256 @@ extern	lr_aptr	head_lr_arc, tail_lr_arc;
 extern	rl_aptr	head_rl_arc, tail_rl_arc;
 #endif
 
+/*
+How input node numbers map to ours: the input's rhs node numbers
+start after in_id_offset, and if in_swap is set, its lhs nodes are
+our rhs nodes and vice versa.
+*/
+unsigned	in_id_offset;
+int		in_swap;
+
+#ifdef	INCREMENTAL
+/*
+Whether the instance was followed by a batch of updates; see incr.c.
+*/
+int		updates_follow = FALSE;
+#endif
+
+#ifdef	COMPONENTS
+/*
+Connected components of the input graph. The nodes of each component
+are renumbered to be contiguous, components in order of their first
+lhs node and nodes within a component in input order, so each
+component's arcs are contiguous, too, and a connected input keeps its
+numbering. Component c has lhs nodes comp_lhs[c] through
+comp_lhs[c+1] - 1, and likewise for rhs nodes. lhs_pos[] maps input
+lhs node numbers (from zero) to positions, and rhs_id[] maps rhs
+positions back to input numbers, for the output.
+*/
+unsigned	num_comps;
+lhs_ptr		*comp_lhs;
+rhs_ptr		*comp_rhs;
+unsigned	*lhs_pos, *rhs_id;
+
+static	unsigned	uf_find(parent, i)
+
+unsigned	*parent, i;
+
+{
+unsigned	r, t;
+
+for (r = i; parent[r] != r; r = parent[r]) ;
+for (; i != r; i = t)
+  {
+  t = parent[i];
+  parent[i] = r;
+  }
+return(r);
+}
+
+static	void	order_components(temp_arcs, lhs_n, rhs_n, lhs_degree,
+				 rhs_degree)
+
+ta_ptr		temp_arcs;
+unsigned	lhs_n, rhs_n;
+long		*lhs_degree, *rhs_degree;
+
+{
+unsigned	*parent, *comp, *rhs_pos, *lhs_start, *rhs_start, i, r;
+long		*deg;
+ta_ptr		ta;
+
+parent = (unsigned *) malloc((lhs_n + rhs_n) * sizeof(unsigned));
+comp = (unsigned *) malloc((lhs_n + rhs_n) * sizeof(unsigned));
+lhs_pos = (unsigned *) malloc(lhs_n * sizeof(unsigned));
+rhs_pos = (unsigned *) malloc(rhs_n * sizeof(unsigned));
+rhs_id = (unsigned *) malloc(rhs_n * sizeof(unsigned));
+deg = (long *) malloc((lhs_n > rhs_n ? lhs_n : rhs_n) * sizeof(long));
+if ((parent == NULL) || (comp == NULL) || (lhs_pos == NULL) ||
+    (rhs_pos == NULL) || (rhs_id == NULL) || (deg == NULL))
+  parse_error(NOMEM);
+
+/*
+Union the ends of every arc; rhs node j is element lhs_n + j.
+*/
+for (i = 0; i < lhs_n + rhs_n; i++)
+  {
+  parent[i] = i;
+  comp[i] = lhs_n + rhs_n;
+  }
+for (ta = temp_arcs; ta != temp_arcs + m; ta++)
+  {
+  i = uf_find(parent, (unsigned) (ta->tail - head_lhs_node));
+  r = uf_find(parent, lhs_n + (unsigned) (ta->head - head_rhs_node));
+  if (i != r)
+    parent[r] = i;
+  }
+num_comps = 0;
+for (i = 0; i < lhs_n + rhs_n; i++)
+  {
+  r = uf_find(parent, i);
+  if (comp[r] == lhs_n + rhs_n)
+    comp[r] = num_comps++;
+  comp[i] = comp[r];
+  }
+
+/*
+Lay the components out in order.
+*/
+lhs_start = (unsigned *) calloc(num_comps + 1, sizeof(unsigned));
+rhs_start = (unsigned *) calloc(num_comps + 1, sizeof(unsigned));
+comp_lhs = (lhs_ptr *) malloc((num_comps + 1) * sizeof(lhs_ptr));
+comp_rhs = (rhs_ptr *) malloc((num_comps + 1) * sizeof(rhs_ptr));
+if ((lhs_start == NULL) || (rhs_start == NULL) ||
+    (comp_lhs == NULL) || (comp_rhs == NULL))
+  parse_error(NOMEM);
+for (i = 0; i < lhs_n; i++)
+  lhs_start[comp[i] + 1]++;
+for (i = 0; i < rhs_n; i++)
+  rhs_start[comp[lhs_n + i] + 1]++;
+for (r = 0; r <= num_comps; r++)
+  {
+  if (r > 0)
+    {
+    lhs_start[r] += lhs_start[r - 1];
+    rhs_start[r] += rhs_start[r - 1];
+    }
+  comp_lhs[r] = head_lhs_node + lhs_start[r];
+  comp_rhs[r] = head_rhs_node + rhs_start[r];
+  }
+for (i = 0; i < lhs_n; i++)
+  lhs_pos[i] = lhs_start[comp[i]]++;
+for (i = 0; i < rhs_n; i++)
+  {
+  rhs_pos[i] = rhs_start[comp[lhs_n + i]]++;
+  rhs_id[rhs_pos[i]] = i;
+  }
+
+/*
+Renumber the arc ends and the degrees to match.
+*/
+for (ta = temp_arcs; ta != temp_arcs + m; ta++)
+  {
+  ta->tail = head_lhs_node + lhs_pos[ta->tail - head_lhs_node];
+  ta->head = head_rhs_node + rhs_pos[ta->head - head_rhs_node];
+  }
+for (i = 0; i < lhs_n; i++)
+  deg[lhs_pos[i]] = lhs_degree[i];
+for (i = 0; i < lhs_n; i++)
+  lhs_degree[i] = deg[i];
+if (rhs_degree)
+  {
+  for (i = 0; i < rhs_n; i++)
+    deg[rhs_pos[i]] = rhs_degree[i];
+  for (i = 0; i < rhs_n; i++)
+    rhs_degree[i] = deg[i];
+  }
+
+(void) free((char *) parent);
+(void) free((char *) comp);
+(void) free((char *) rhs_pos);
+(void) free((char *) lhs_start);
+(void) free((char *) rhs_start);
+(void) free((char *) deg);
+}
+#endif	/* COMPONENTS */
+
+#ifdef	DENSE_JV
+/*
+A cost matrix, read in place of DIMACS input when the input starts
+with the four characters of DENSE_MAGIC: the number of rows and then
+of columns, no fewer, and the costs a row at a time, all of them
+32-bit little-endian integers. Row i is lhs node i + 1 and column j
+rhs node rows + j + 1, as in DIMACS input with the lhs nodes first.
+The costs stay in jv_cost[] for the dense solver (see jv.c), and each
+lhs node gets a single arc, which will be its matching arc.
+*/
+extern	double	*jv_cost;
+extern	int	jv_from_matrix;
+
+static	long	get_word(b)
+
+unsigned char	*b;
+
+{
+unsigned long	u;
+
+u = (unsigned long) b[0] | ((unsigned long) b[1] << 8) |
+    ((unsigned long) b[2] << 16) | ((unsigned long) b[3] << 24);
+return((u & 0x80000000UL) ? (long) u - 0x100000000L : (long) u);
+}
+
+static	unsigned long	parse_matrix()
+
+{
+unsigned char	*buf, head[11];
+unsigned	rows, cols, i, j;
+unsigned long	max_cost = 0;
+long		cost;
+double		*cell;
+lhs_ptr		l_v;
+rhs_ptr		r_v;
+
+if ((fread((char *) head, 1, 11, PARSE_IN) != 11) ||
+    (head[0] != DENSE_MAGIC[1]) || (head[1] != DENSE_MAGIC[2]) ||
+    (head[2] != DENSE_MAGIC[3]) ||
+    ((rows = (unsigned) get_word(head + 3)) == 0) ||
+    ((cols = (unsigned) get_word(head + 7)) < rows))
+  parse_error(BADMATRIX);
+n = rows + cols;
+m = rows * cols;
+in_id_offset = rows;
+in_swap = FALSE;
+
+jv_cost = (double *) malloc((unsigned long) rows * cols * sizeof(double));
+buf = (unsigned char *) malloc(4 * cols);
+head_lr_arc = (lr_aptr) malloc((rows + 1) * sizeof(struct lr_arc));
+tail_lr_arc = head_lr_arc + rows;
+head_lhs_node = (lhs_ptr) malloc((rows + 1) * sizeof(struct lhs_node));
+tail_lhs_node = head_lhs_node + rows;
+head_rhs_node = (rhs_ptr) malloc((cols + 1) * sizeof(struct rhs_node));
+tail_rhs_node = head_rhs_node + cols;
+if ((jv_cost == NULL) || (buf == NULL) || (head_lr_arc == NULL) ||
+    (head_lhs_node == NULL) || (head_rhs_node == NULL))
+  parse_error(NOMEM);
+(void) puts(banner);
+
+cell = jv_cost;
+for (i = 0; i < rows; i++)
+  {
+  if (fread((char *) buf, 4, cols, PARSE_IN) != cols)
+    parse_error(BADMATRIX);
+  for (j = 0; j < cols; j++)
+    {
+    cost = get_word(buf + 4 * j);
+    if ((unsigned long) labs(cost) > max_cost)
+      max_cost = labs(cost);
+#ifdef	MIN_COST
+    *cell++ = (double) cost;
+#else
+    *cell++ = (double) -cost;
+#endif
+    }
+  }
+(void) free((char *) buf);
+
+for (i = 0, l_v = head_lhs_node; l_v != tail_lhs_node; l_v++, i++)
+  {
+  l_v->priced_out = l_v->first = head_lr_arc + i;
+  l_v->matched = NULL;
+  }
+tail_lhs_node->priced_out = tail_lr_arc;
+for (r_v = head_rhs_node; r_v != tail_rhs_node; r_v++)
+  {
+  r_v->node_info.priced_in = TRUE;
+  r_v->matched = NULL;
+  r_v->p = 0.0;
+  }
+jv_from_matrix = TRUE;
+return(max_cost);
+}
+#endif
+
 unsigned long	parse()
 
 {
@@ -63,16 +362,30 @@ long	cost, *lhs_degree;
 long	*rhs_degree;
 rl_aptr	b;
 #endif
-unsigned long	max_cost = 0;
+unsigned long	max_cost = 0, arc_room;
 lr_aptr	a;
 ta_ptr	temp_a, temp_arcs;
 lhs_ptr	l_v;
 rhs_ptr	r_v;
 extern	int	abs();
+#ifdef	CAPACITY
+/*
+capacities of the nodes by input number, from zero; those of lhs
+nodes are ignored.
+*/
+unsigned	*in_cap, cap_sum;
+slot_ptr	s;
+#endif
+
+#ifdef	DENSE_JV
+if ((temp = getc(PARSE_IN)) == DENSE_MAGIC[0])
+  return(parse_matrix());
+(void) ungetc((int) temp, PARSE_IN);
+#endif
 
 /* skip initial comments */
 do
-  if (fgets(in_line, sizeof(in_line), stdin) == NULL)
+  if (fgets(in_line, sizeof(in_line), PARSE_IN) == NULL)
     parse_error(BADINPUT1);
 while (in_line[0] == 'c');
 
@@ -85,8 +398,19 @@ if ((sscanf(in_line, "%c%3s%d%d", &line_type, prob_type, &n, &m) != 4) ||
 
 arc_count = 0;
 lhs_n = 0;
+id_offset = 0;
+#ifdef	CAPACITY
+if ((in_cap = (unsigned *) malloc((n ? n : 1) * sizeof(unsigned))) == NULL)
+  parse_error(NOMEM);
+for (temp = 0; temp < n; temp++)
+  in_cap[temp] = 1;
+#endif
 
-while (fgets(in_line, sizeof(in_line), stdin) != NULL)
+while ((fgets(in_line, sizeof(in_line), PARSE_IN) != NULL)
+#ifdef	INCREMENTAL
+       && !(updates_follow = (in_line[0] == 'u'))
+#endif
+      )
   switch (in_line[0])
     {
     case 'c': break;
@@ -98,17 +422,46 @@ while (fgets(in_line, sizeof(in_line), stdin) != NULL)
 	parse_error(NONCONTIG);
       break;
 
+#ifdef	CAPACITY
+    /*
+    r id cap: rhs node id may be matched to up to cap lhs nodes.
+    */
+    case 'r':
+      if ((sscanf(in_line, "%*c%u%u", &node_id, &temp) != 2) ||
+	  (node_id < 1) || (node_id > n) || (temp < 1))
+	parse_error(BADINPUT3);
+      in_cap[node_id - 1] = temp;
+      break;
+#endif
+
     case 'a':
       if (!lhs_known)
 	{
 	lhs_known = TRUE;
-	head_lr_arc = (lr_aptr) malloc((m + 1) * sizeof(struct lr_arc));
-	tail_lr_arc = head_lr_arc + m;
+#ifdef	INCREMENTAL
+	/*
+	Leave INCR_ROOM arcs of room in each lhs node's list.
+	*/
+	arc_room = m + INCR_ROOM * (lhs_n > n - lhs_n ? n - lhs_n : lhs_n);
+#else
+	arc_room = m;
+#endif
+	head_lr_arc = (lr_aptr) parse_alloc(LR_ARCS,
+				(arc_room + 1) * sizeof(struct lr_arc));
+	tail_lr_arc = head_lr_arc + arc_room;
 #ifdef	STORE_REV_ARCS
-	head_rl_arc = (rl_aptr) malloc((m + 1) * sizeof(struct rl_arc));
+	head_rl_arc = (rl_aptr) parse_alloc(RL_ARCS,
+				(m + 1) * sizeof(struct rl_arc));
 	tail_rl_arc = head_rl_arc + m;
 #endif
 	id_offset = lhs_n;
+#ifdef	CAPACITY
+	/*
+	The rhs nodes are the ones with capacities, whichever side is
+	the bigger.
+	*/
+	swap = FALSE;
+#else
 	if (lhs_n > n - lhs_n)
 	  {
 	  lhs_n = n - lhs_n;
@@ -116,28 +469,36 @@ while (fgets(in_line, sizeof(in_line), stdin) != NULL)
 	  }
 	else
 	  swap = FALSE;
-	head_lhs_node = (lhs_ptr) malloc((lhs_n + 1) *
+#endif
+	in_id_offset = id_offset;
+	in_swap = swap;
+	head_lhs_node = (lhs_ptr) parse_alloc(LHS_NODES, (lhs_n + 1) *
 					 sizeof(struct lhs_node));
 	tail_lhs_node = head_lhs_node + lhs_n;
-	head_rhs_node = (rhs_ptr) malloc((n - lhs_n + 1) *
+	head_rhs_node = (rhs_ptr) parse_alloc(RHS_NODES, (n - lhs_n + 1) *
 					 sizeof(struct rhs_node));
 	tail_rhs_node = head_rhs_node + n - lhs_n;
-	lhs_degree = (long *) malloc(lhs_n * sizeof(long));
+	lhs_degree = (long *) parse_alloc(LHS_DEGREES,
+					  lhs_n * sizeof(long));
 #ifdef	STORE_REV_ARCS
-	rhs_degree = (long *) malloc((n - lhs_n) * sizeof(long));
+	rhs_degree = (long *) parse_alloc(RHS_DEGREES,
+					  (n - lhs_n) * sizeof(long));
 	if ((rhs_degree == NULL) || (head_rl_arc == NULL))
 	  parse_error(NOMEM);
 	for (tail = 0; tail < n - lhs_n; tail++)
 	  rhs_degree[tail] = 0;
 #endif
-	temp_arcs = (ta_ptr) malloc(m * sizeof(struct temp_arc));
+	temp_arcs = (ta_ptr) parse_alloc(TEMP_ARCS,
+				       m * sizeof(struct temp_arc));
 	if ((head_lhs_node == NULL) || (head_lr_arc == NULL) ||
 	    (lhs_degree == NULL) || (temp_arcs == NULL))
 	  parse_error(NOMEM);
 	temp_a = temp_arcs;
 	for (tail = 0; tail < lhs_n; tail++)
 	  lhs_degree[tail] = 0;
+#ifndef	AUTO_TUNE
 	(void) puts(banner);
+#endif
 	}
       if (sscanf(in_line, "%*c%d%d%ld", &tail, &head, &cost) == 0)
 	parse_error(BADINPUT4);
@@ -180,29 +541,88 @@ while (fgets(in_line, sizeof(in_line), stdin) != NULL)
 if (arc_count != m)
   parse_error(BADCOUNT);
 
+#ifdef	COMPONENTS
+#ifdef	STORE_REV_ARCS
+order_components(temp_arcs, lhs_n, n - lhs_n, lhs_degree, rhs_degree);
+#else
+order_components(temp_arcs, lhs_n, n - lhs_n, lhs_degree, (long *) NULL);
+#endif
+#endif
+
 a = head_lr_arc;
 for (tail = 0, l_v = head_lhs_node; l_v != tail_lhs_node; l_v++, tail++)
   {
+#ifdef	INCREMENTAL
+  /*
+  The room is a run of dead arcs, kept priced out so that no part of
+  the solver ever looks at them but the price-in checks, which their
+  cost keeps out.
+  */
+  l_v->priced_out = a;
+  for (temp = 0; temp < INCR_ROOM; temp++, a++)
+    {
+    a->head = head_rhs_node;
+    a->c = INCR_DEAD;
+    }
+  l_v->first = a;
+#else
   l_v->priced_out = l_v->first = a;
+#endif
   l_v->matched = NULL;
+#ifdef	IMPERFECT
+  l_v->null_p = 0.0;
+#endif
   a += lhs_degree[tail];
 #ifdef	QUICK_MIN
   if (lhs_degree[tail] < NUM_BEST + 1)
     l_v->node_info.few_arcs = TRUE;
   else
     l_v->node_info.few_arcs = FALSE;
+#endif
+#ifdef	DEGREE_KERNELS
+  if (lhs_degree[tail] > MAX_KERNEL_DEG)
+    l_v->node_info.deg_class = MAX_KERNEL_DEG + 1;
+  else
+    l_v->node_info.deg_class = lhs_degree[tail];
 #endif
   }
 tail_lhs_node->priced_out = a;
 
+#ifdef	CAPACITY
+cap_sum = 0;
+for (temp = id_offset; temp < n; temp++)
+  cap_sum += in_cap[temp];
+#ifndef	IMPERFECT
+if (cap_sum < lhs_n)
+  parse_error(NOROOM);
+#endif
+if ((s = (slot_ptr) malloc((cap_sum ? cap_sum : 1) *
+			   sizeof(struct slot))) == NULL)
+  parse_error(NOMEM);
+#endif
 #ifdef	STORE_REV_ARCS
 tail = 0;
 b = head_rl_arc;
 #endif
 for (r_v = head_rhs_node; r_v != tail_rhs_node; r_v++)
   {
+#ifdef	CAPACITY
+  r_v->cap = in_cap[id_offset + (r_v - head_rhs_node)];
+  r_v->slots = s;
+  for (temp = 0; temp < r_v->cap; temp++, s++)
+    {
+    s->mate = NULL;
+    s->p = 0.0;
+    }
+#endif
   r_v->node_info.priced_in = TRUE;
   r_v->matched = NULL;
+#ifdef	BATCH_REFINE
+  r_v->batch = 0;
+#endif
+#ifdef	DET_PAR_REFINE
+  r_v->claim = NULL;
+#endif
 #ifdef	STORE_REV_ARCS
   r_v->priced_out = r_v->back_arcs = b;
   b += rhs_degree[tail];
@@ -258,10 +678,13 @@ In the ROUND_COSTS case, update_epsilon() takes care of b->c.
 #endif
   }
 
-(void) free((char *) temp_arcs);
-(void) free((char *) lhs_degree);
+parse_free(temp_arcs);
+parse_free(lhs_degree);
+#ifdef	CAPACITY
+(void) free((char *) in_cap);
+#endif
 #ifdef	STORE_REV_ARCS
-(void) free((char *) rhs_degree);
+parse_free(rhs_degree);
 #endif
 
 return(max_cost);
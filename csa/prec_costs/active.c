@@ -0,0 +1,141 @@
+#include	<stdio.h>
+#include	<stdlib.h>
+#include	"csa_types.h"
+#include	"csa_defs.h"
+
+/*
+Active-node orderings other than stack and FIFO. The active set is
+kept as an array of buckets, each a list of lhs nodes linked through
+their next_active fields, so every operation takes constant time. The
+policies differ only in which bucket a node goes into and which
+bucket the next node comes from:
+
+WAVE_ORDER	Two buckets: nodes activated while a wave is being
+		processed wait for the next wave, so a node displaced
+		during the current pass is processed after every node
+		that was already active when the pass began.
+PRICE_ORDER	Nodes displaced by a double push go into the bucket
+		for the binary order of magnitude of the price drop
+		(in units of epsilon) of the rhs node they lost; all
+		other activations go into bucket 0. Nodes are taken
+		from the lowest nonempty bucket, so a node that was
+		displaced by a large price drop waits until the
+		nodes with small drops are settled. (Taking them
+		from the highest bucket instead processes nodes in
+		exactly the stack order, since at most one displaced
+		node is pending at a time.)
+LOCALITY_ORDER	One bucket for each LOCALITY_BLOCK bytes of the arc
+		array; a node goes into the bucket holding the start of
+		its arc list. Nonempty buckets are served in FIFO
+		order, each until it's empty, so consecutive double
+		pushes tend to touch the same part of the arc array.
+*/
+
+#define	PRICE_BUCKETS	32
+#define	LOCALITY_BLOCK	16384
+
+extern	char		*nomem_msg;
+#ifdef	LOCALITY_ORDER
+extern	unsigned	m;
+extern	lr_aptr		head_lr_arc;
+#endif
+
+keyed	ka_create(size)
+
+unsigned	size;
+
+{
+keyed		s;
+unsigned	i;
+void	exit();
+
+s = (keyed) malloc(sizeof(struct keyed_st));
+if (s == NULL)
+  {
+  (void) printf("%s", nomem_msg);
+  exit(9);
+  }
+#if	defined(WAVE_ORDER)
+s->num_buckets = 2;
+#elif	defined(PRICE_ORDER)
+s->num_buckets = PRICE_BUCKETS;
+#else
+s->num_buckets = (m + 1) * sizeof(struct lr_arc) / LOCALITY_BLOCK + 1;
+s->ring = (unsigned *) malloc(s->num_buckets * sizeof(unsigned));
+if (s->ring == NULL)
+  {
+  (void) printf("%s", nomem_msg);
+  exit(9);
+  }
+s->ring_head = s->ring_tail = 0;
+#endif
+s->bucket = (lhs_ptr *) malloc(s->num_buckets * sizeof(lhs_ptr));
+if (s->bucket == NULL)
+  {
+  (void) printf("%s", nomem_msg);
+  exit(9);
+  }
+for (i = 0; i < s->num_buckets; i++)
+  s->bucket[i] = NULL;
+s->cur = 0;
+return(s);
+}
+
+void	ka_insert(s, v, key)
+
+keyed		s;
+lhs_ptr		v;
+unsigned	key;
+
+{
+#if	defined(WAVE_ORDER)
+key = s->cur ^ 1;
+#elif	defined(PRICE_ORDER)
+if (key >= PRICE_BUCKETS)
+  key = PRICE_BUCKETS - 1;
+if (key < s->cur)
+  s->cur = key;
+#else
+key = (char *) v->priced_out - (char *) head_lr_arc;
+key /= LOCALITY_BLOCK;
+if (s->bucket[key] == NULL)
+  {
+  s->ring[s->ring_tail] = key;
+  if (++s->ring_tail == s->num_buckets)
+    s->ring_tail = 0;
+  }
+#endif
+v->next_active = s->bucket[key];
+s->bucket[key] = v;
+}
+
+/*
+Remove and return the next active node. The active set must not be
+empty.
+*/
+
+lhs_ptr	ka_remove(s)
+
+keyed	s;
+
+{
+lhs_ptr	v;
+
+#if	defined(WAVE_ORDER)
+if (s->bucket[s->cur] == NULL)
+  s->cur ^= 1;
+#elif	defined(PRICE_ORDER)
+while (s->bucket[s->cur] == NULL)
+  s->cur++;
+#else
+s->cur = s->ring[s->ring_head];
+#endif
+v = s->bucket[s->cur];
+s->bucket[s->cur] = v->next_active;
+#ifdef	LOCALITY_ORDER
+if (s->bucket[s->cur] == NULL)
+  if (++s->ring_head == s->num_buckets)
+    s->ring_head = 0;
+#endif
+return(v);
+}
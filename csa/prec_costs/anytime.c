@@ -0,0 +1,188 @@
+#include	<stdio.h>
+#include	<stdlib.h>
+#include	"csa_types.h"
+#include	"csa_defs.h"
+
+/*
+Anytime solution under a time limit or a bound on the distance from
+optimal. After each refine the matching is perfect, and we take its
+cost and a lower bound on the optimum from the prices: for any prices
+p, the sum over lhs nodes v of the least partial reduced cost of an
+arc out of v, plus the sum of the rhs prices, is at most the cost of
+every perfect matching. The difference, the gap, bounds the distance
+of the matching from optimal; when the matching is epsilon-optimal it
+is at most epsilon times the number of lhs nodes, but the bound holds
+whatever price-outs have done to epsilon-optimality. Scaling stops
+after the first refine that leaves the gap within gap_limit or runs
+past time_limit seconds.
+
+So that a refine running past the time limit needn't be finished,
+the matching is saved after each refine, as the rhs node and cost of
+each matched arc rather than the arc itself since price-outs move arcs
+about; the cost tells parallel arcs apart. The sequential refine loop
+checks the clock every ANYTIME_CHECK double pushes and gives up once
+the time limit is past, if a refine has finished before, and the saved
+matching is put back; the first refine always runs to the end. The
+multi-threaded refines only stop between refines.
+*/
+
+extern	lhs_ptr		head_lhs_node, tail_lhs_node;
+extern	rhs_ptr		head_rhs_node, tail_rhs_node;
+extern	double		epsilon, min_epsilon;
+extern	double		time_limit, gap_limit;
+extern	double		fine_clock(), compute_cost();
+
+unsigned	anytime_ticks = 0;
+int		anytime_aborted = FALSE;
+
+/*
+One line of progress per refine.
+*/
+typedef	struct	phase	{
+			double	time, eps, cost, gap;
+			}	phase;
+
+static	phase		*phases = NULL;
+static	unsigned	phases_n = 0, phases_room = 0;
+static	rhs_ptr		*saved = NULL;
+static	double		*saved_c = NULL;
+static	double		start;
+
+void	anytime_start()
+
+{
+void	exit();
+
+start = fine_clock();
+saved = (rhs_ptr *) malloc((tail_lhs_node - head_lhs_node + 1) *
+			   sizeof(rhs_ptr));
+saved_c = (double *) malloc((tail_lhs_node - head_lhs_node + 1) *
+			    sizeof(double));
+if ((saved == NULL) || (saved_c == NULL))
+  {
+  (void) printf("Error: no memory for the saved matching\n");
+  exit(9);
+  }
+}
+
+/*
+Called from the refine loop once every ANYTIME_CHECK double pushes:
+whether to give up on the refine.
+*/
+
+int	anytime_expired()
+
+{
+if ((phases_n > 0) && (time_limit > 0.0) &&
+    (fine_clock() - start > time_limit))
+  anytime_aborted = TRUE;
+return(anytime_aborted);
+}
+
+/*
+Lower bound on the cost of any perfect matching, from the prices.
+*/
+
+static	double	dual_bound()
+
+{
+lhs_ptr	v;
+rhs_ptr	w;
+lr_aptr	a, a_stop;
+double	bound = 0.0, least, red_cost;
+
+for (v = head_lhs_node; v != tail_lhs_node; v++)
+  {
+  a_stop = (v + 1)->priced_out;
+  least = 0.0;
+  for (a = v->priced_out; a != a_stop; a++)
+    {
+    red_cost = a->c - a->head->p;
+    if ((a == v->priced_out) || (red_cost < least))
+      least = red_cost;
+    }
+  bound += least;
+  }
+for (w = head_rhs_node; w != tail_rhs_node; w++)
+  bound += w->p;
+return(bound);
+}
+
+static	void	restore()
+
+{
+lhs_ptr	v;
+rhs_ptr	w;
+lr_aptr	a;
+
+for (w = head_rhs_node; w != tail_rhs_node; w++)
+  w->matched = NULL;
+for (v = head_lhs_node; v != tail_lhs_node; v++)
+  {
+  for (a = v->priced_out; (a->head != saved[v - head_lhs_node]) ||
+			  (a->c != saved_c[v - head_lhs_node]); a++)
+    ;
+  v->matched = a;
+  a->head->matched = v;
+  }
+}
+
+/*
+Called after each refine: record its progress, and return whether to
+stop scaling.
+*/
+
+int	anytime_done()
+
+{
+lhs_ptr	v;
+phase	*ph;
+void	exit();
+
+if (anytime_aborted)
+  {
+  restore();
+  return(TRUE);
+  }
+if (phases_n == phases_room)
+  {
+  phases_room = phases_room ? 2 * phases_room : 16;
+  phases = (phase *) realloc((char *) phases, phases_room * sizeof(phase));
+  if (phases == NULL)
+    {
+    (void) printf("Error: no memory for the anytime progress\n");
+    exit(9);
+    }
+  }
+ph = &phases[phases_n++];
+ph->time = fine_clock() - start;
+ph->eps = epsilon;
+ph->cost = compute_cost();
+ph->gap = ph->cost - dual_bound();
+if (ph->gap < 0.0)
+  ph->gap = 0.0;
+for (v = head_lhs_node; v != tail_lhs_node; v++)
+  {
+  saved[v - head_lhs_node] = v->matched->head;
+  saved_c[v - head_lhs_node] = v->matched->c;
+  }
+return(((time_limit > 0.0) && (ph->time > time_limit)) ||
+       ((gap_limit > 0.0) && (ph->gap <= gap_limit)));
+}
+
+void	display_anytime()
+
+{
+unsigned	i;
+
+for (i = 0; i < phases_n; i++)
+  (void) printf("|>   at %8.3f s, epsilon %-10lg cost %17.0f, gap %lg\n",
+		phases[i].time, phases[i].eps, phases[i].cost,
+		phases[i].gap);
+if (phases_n > 0)
+  (void) printf("|>   %s; cost within %lg of optimal\n",
+		anytime_aborted ? "last refine abandoned" :
+		(phases[phases_n - 1].eps > min_epsilon ? "stopped early" :
+		 "scaling finished"),
+		phases[phases_n - 1].gap);
+}
@@ -0,0 +1,416 @@
+#include	<stdio.h>
+#include	<stdlib.h>
+#include	"csa_types.h"
+#include	"csa_defs.h"
+
+/*
+Forward-reverse auction, in place of refine(): built from this file
+instead of refine.c, it shares the node and arc arrays, the epsilon
+scaling in cost_scaling(), update_epsilon()'s price-outs and, in the
+STRONG_PO case, check_po_arcs(). Like a refine, each auction phase
+starts from every lhs node unmatched, except those whose matching
+arcs are priced out, and ends with an epsilon-optimal perfect
+matching.
+
+Forward bids are double pushes: a free lhs node v takes the rhs node
+of least partial reduced cost, evicting its mate, and lowers its price
+by the difference from the second least plus epsilon. Reverse bids go
+the other way: a free rhs node w offers to each lhs node u adjacent to
+it along a priced-in arc the price at which u would do as well at w
+as it does now, c(u, w) - q(u), where q(u) is the partial reduced cost
+of u's matching arc, or for a free u the bound kept for it; w takes
+the lowest bidder and raises its price to the second-lowest offer
+plus epsilon, which keeps every other lhs node adjacent to w within
+epsilon of its best. The rhs node the winner leaves is free in turn.
+A free lhs node's bound starts at its least partial reduced cost, and
+an evicted node's is the partial reduced cost of the arc it loses,
+before the price drop, which is within epsilon of its least. Forward
+rounds bid once for every lhs node free at their start, and go on
+after that until the matching has grown, which guarantees termination.
+Once no more than one in AUCTION_TAIL lhs nodes is free, reverse
+rounds, each bidding once for every rhs node free at its start,
+alternate with them; earlier on, reverse bids only undo the price
+drops of forward ones and multiply the bidding. Reverse bids need the
+lhs nodes adjacent to each rhs node, listed from the priced-in arcs,
+and with price-outs listed again at the start of each phase and after
+check_po_arcs() has priced arcs in.
+
+Reverse bids raise prices, so a priced-out arc can become admissible,
+and price-outs need STRONG_PO: check_po_arcs() finds such arcs once
+every lhs node is matched, as it does after a refine, and the nodes
+it unmatches bid again. It isn't called along the way.
+*/
+
+extern	lhs_ptr		head_lhs_node, tail_lhs_node;
+extern	rhs_ptr		head_rhs_node, tail_rhs_node;
+extern	lr_aptr		head_lr_arc;
+extern	double		epsilon, po_cost_thresh;
+extern	unsigned	total_e;
+extern	ACTIVE_TYPE	active;
+extern	PAR_LOCAL unsigned	double_pushes, pushes, relabelings, refines,
+				refine_time;
+extern	unsigned	myclock();
+extern	char		*st_pop(), *deq();
+#ifdef	STRONG_PO
+extern	int		check_po_arcs();
+#endif
+
+/*
+The priced-in arcs into rhs node j are rev_arc[rev_first[j]], ...,
+rev_arc[rev_first[j + 1] - 1], and rev_tail[] has their tails.
+*/
+static	unsigned	*rev_first = NULL;
+static	lr_aptr		*rev_arc;
+static	lhs_ptr		*rev_tail;
+/*
+q[i] is the bound kept for free lhs node i, and in_set[i] whether i
+is in the active set, where it may stay a while after a reverse bid
+has matched it; set_n counts the nodes there.
+*/
+static	double		*q;
+static	char		*in_set;
+static	unsigned	set_n;
+/*
+Free rhs nodes waiting to bid, in a ring of free_n starting at
+free_rhs[free_head], and whether each is among them.
+*/
+static	rhs_ptr		*free_rhs;
+static	unsigned	free_head, free_n, rhs_n;
+static	char		*queued;
+static	unsigned long	f_bids = 0, r_bids = 0;
+
+static	void	auction_init()
+
+{
+unsigned	lhs_n = tail_lhs_node - head_lhs_node,
+		m = tail_lhs_node->priced_out - head_lr_arc;
+void	exit();
+
+rhs_n = tail_rhs_node - head_rhs_node;
+
+rev_first = (unsigned *) malloc((rhs_n + 1) * sizeof(unsigned));
+rev_arc = (lr_aptr *) malloc((m ? m : 1) * sizeof(lr_aptr));
+rev_tail = (lhs_ptr *) malloc((m ? m : 1) * sizeof(lhs_ptr));
+q = (double *) malloc((lhs_n ? lhs_n : 1) * sizeof(double));
+in_set = (char *) calloc(lhs_n ? lhs_n : 1, 1);
+free_rhs = (rhs_ptr *) malloc((rhs_n ? rhs_n : 1) * sizeof(rhs_ptr));
+queued = (char *) calloc(rhs_n ? rhs_n : 1, 1);
+if ((rev_first == NULL) || (rev_arc == NULL) || (rev_tail == NULL) ||
+    (q == NULL) || (in_set == NULL) || (free_rhs == NULL) ||
+    (queued == NULL))
+  {
+  (void) printf("Error: no memory for the auction\n");
+  exit(9);
+  }
+}
+
+static	void	activate(v)
+
+lhs_ptr	v;
+
+{
+if (!in_set[v - head_lhs_node])
+  {
+  in_set[v - head_lhs_node] = TRUE;
+  set_n++;
+  make_active(v);
+  }
+}
+
+static	void	free_push(w)
+
+rhs_ptr	w;
+
+{
+if (!queued[w - head_rhs_node])
+  {
+  queued[w - head_rhs_node] = TRUE;
+  free_rhs[(free_head + free_n++) % rhs_n] = w;
+  }
+}
+
+/*
+List the priced-in arcs by head. Only price-outs move arcs, so without
+them this is done once.
+*/
+
+static	void	rev_list()
+
+{
+unsigned	j;
+lhs_ptr	v;
+lr_aptr	a, a_stop;
+
+for (j = 0; j <= rhs_n; j++)
+  rev_first[j] = 0;
+for (v = head_lhs_node; v != tail_lhs_node; v++)
+  {
+  a_stop = (v + 1)->priced_out;
+  for (a = v->first; a != a_stop; a++)
+    rev_first[a->head - head_rhs_node + 1]++;
+  }
+for (j = 0; j < rhs_n; j++)
+  rev_first[j + 1] += rev_first[j];
+for (v = head_lhs_node; v != tail_lhs_node; v++)
+  {
+  a_stop = (v + 1)->priced_out;
+  for (a = v->first; a != a_stop; a++)
+    {
+    j = a->head - head_rhs_node;
+    rev_arc[rev_first[j]] = a;
+    rev_tail[rev_first[j]++] = v;
+    }
+  }
+for (j = rhs_n; j > 0; j--)
+  rev_first[j] = rev_first[j - 1];
+rev_first[0] = 0;
+}
+
+/*
+Take stock of the free nodes and set the bounds of the free lhs nodes,
+at the start of a phase or after price-ins.
+*/
+
+static	void	resync()
+
+{
+unsigned	j;
+lhs_ptr	v;
+rhs_ptr	w;
+lr_aptr	a, a_stop;
+double	red_cost;
+
+#ifdef	USE_PRICE_OUT
+rev_list();
+#endif
+for (v = head_lhs_node; v != tail_lhs_node; v++)
+  if (v->matched == NULL)
+    {
+    a_stop = (v + 1)->priced_out;
+    q[v - head_lhs_node] = 0.0;
+    for (a = v->first; a != a_stop; a++)
+      {
+      red_cost = a->c - a->head->p;
+      if ((a == v->first) || (red_cost < q[v - head_lhs_node]))
+	q[v - head_lhs_node] = red_cost;
+      }
+    activate(v);
+    }
+
+for (j = 0; j < free_n; j++)
+  queued[free_rhs[(free_head + j) % rhs_n] - head_rhs_node] = FALSE;
+free_head = free_n = 0;
+for (w = head_rhs_node; w != tail_rhs_node; w++)
+  if (w->matched == NULL)
+    free_push(w);
+}
+
+static	void	forward_bid(v)
+
+lhs_ptr	v;
+
+{
+lr_aptr	a, a_stop, adm;
+double	v_pref, v_second, red_cost;
+rhs_ptr	w;
+lhs_ptr	u;
+
+a_stop = (v + 1)->priced_out;
+a = adm = v->first;
+v_pref = a->c - a->head->p;
+v_second = v_pref + epsilon * (po_cost_thresh + 1.0);
+for (a++; a != a_stop; a++)
+  if (v_pref > (red_cost = a->c - a->head->p))
+    {
+    v_second = v_pref;
+    v_pref = red_cost;
+    adm = a;
+    }
+  else if (v_second > red_cost)
+    v_second = red_cost;
+
+f_bids++;
+relabelings++;
+w = adm->head;
+if ((u = w->matched))
+  {
+  /*
+  As in dp_apply(), a node whose matching arc is priced out keeps it,
+  and is priced out of v's reach instead.
+  */
+  if (!w->node_info.priced_in)
+    {
+    w->p -= epsilon * (po_cost_thresh + 1.0);
+    activate(v);
+    return;
+    }
+  pushes += 2;
+  double_pushes++;
+  q[u - head_lhs_node] = u->matched->c - w->p;
+  u->matched = NULL;
+  activate(u);
+  }
+else
+  {
+  total_e--;
+  pushes++;
+  }
+v->matched = adm;
+w->matched = v;
+w->p -= v_second - v_pref + epsilon;
+}
+
+static	void	reverse_bid(w)
+
+rhs_ptr	w;
+
+{
+unsigned	k, k_stop = rev_first[w - head_rhs_node + 1], best;
+lhs_ptr	u;
+double	offer, o_first = 0.0, o_second = 0.0;
+int	two = FALSE;
+
+k = best = rev_first[w - head_rhs_node];
+if (k == k_stop)
+  return;
+for (; k != k_stop; k++)
+  {
+  u = rev_tail[k];
+  offer = rev_arc[k]->c - (u->matched ?
+			   u->matched->c - u->matched->head->p :
+			   q[u - head_lhs_node]);
+  if (k == rev_first[w - head_rhs_node])
+    o_first = offer;
+  else if (offer < o_first)
+    {
+    o_second = o_first;
+    o_first = offer;
+    best = k;
+    two = TRUE;
+    }
+  else if (!two || (offer < o_second))
+    {
+    o_second = offer;
+    two = TRUE;
+    }
+  }
+if (!two)
+  o_second = o_first + epsilon * po_cost_thresh;
+
+r_bids++;
+relabelings++;
+pushes++;
+u = rev_tail[best];
+if (u->matched)
+  {
+  u->matched->head->matched = NULL;
+  free_push(u->matched->head);
+  }
+else
+  total_e--;
+u->matched = rev_arc[best];
+w->matched = u;
+w->p = o_second + epsilon;
+}
+
+void	refine()
+
+{
+lhs_ptr	v;
+rhs_ptr	w;
+unsigned	k, start_e;
+
+refine_time -= myclock();
+refines++;
+if (rev_first == NULL)
+  {
+  auction_init();
+#ifndef	USE_PRICE_OUT
+  rev_list();
+#endif
+  }
+
+total_e = 0;
+for (v = head_lhs_node; v != tail_lhs_node; v++)
+  {
+  if (v->matched && v->matched->head->node_info.priced_in)
+    {
+    v->matched->head->matched = NULL;
+    v->matched = NULL;
+    }
+  if (v->matched == NULL)
+    total_e++;
+  }
+resync();
+
+for (;;)
+  {
+  while (total_e > 0)
+    {
+    /*
+    A forward round goes on until the matching has grown, and reverse
+    bids never shrink it, so the rounds end.
+    */
+    start_e = total_e;
+    k = set_n;
+    while ((total_e > 0) && ((k > 0) || (total_e == start_e)))
+      {
+      if (k > 0)
+	k--;
+      get_active_node(v);
+      in_set[v - head_lhs_node] = FALSE;
+      set_n--;
+      if (v->matched == NULL)
+	forward_bid(v);
+      }
+    /*
+    Reverse bids only pay once few lhs nodes are left free, when the
+    forward bids that remain fight over the same few rhs nodes.
+    */
+    if (total_e * AUCTION_TAIL > rhs_n)
+      continue;
+    for (k = free_n; (k > 0) && (total_e > 0); k--)
+      {
+      w = free_rhs[free_head];
+      free_head = (free_head + 1) % rhs_n;
+      free_n--;
+      queued[w - head_rhs_node] = FALSE;
+      if (w->matched == NULL)
+	reverse_bid(w);
+      }
+    }
+  /*
+  Empty the active set of the nodes reverse bids have matched.
+  */
+  while (set_n > 0)
+    {
+    get_active_node(v);
+    in_set[v - head_lhs_node] = FALSE;
+    set_n--;
+    }
+#ifdef	STRONG_PO
+  if (check_po_arcs())
+    break;
+  /*
+  check_po_arcs() has made the nodes it unmatched active itself.
+  */
+  for (v = head_lhs_node; v != tail_lhs_node; v++)
+    if (v->matched == NULL)
+      {
+      in_set[v - head_lhs_node] = TRUE;
+      set_n++;
+      }
+  resync();
+#else
+  break;
+#endif
+  }
+
+refine_time += myclock();
+}
+
+void	display_auction()
+
+{
+(void) printf("|>   %lu forward bids, %lu reverse bids\n", f_bids, r_bids);
+}
@@ -0,0 +1,318 @@
+#include	<stdio.h>
+#include	<stdlib.h>
+#include	<string.h>
+#include	<limits.h>
+#include	<math.h>
+#include	<unistd.h>
+#include	"csa_types.h"
+#include	"csa_defs.h"
+
+/*
+Instance-feature-driven selection of the solver variant and its
+tunable parameters. Right after parse(), we compute a handful of cheap
+statistics describing the instance and look them up in a decision
+table. The first table row whose ranges contain the instance wins.
+If the winning variant is not the one we were compiled as and the
+input can be reread, we hand the input over to the winning variant's
+executable. Otherwise we solve the instance ourselves, with the
+parameters of the first row for our own variant that matches.
+
+The decision table is read from the file TUNE_TABLE in the current
+directory if it exists, and from the built-in table below otherwise.
+Each nonblank, noncomment line has the form
+
+	deg small cost n bal variant scale upd_fac po_thresh
+
+where deg, small, cost, n and bal are ranges "lo:hi" (lo inclusive,
+hi exclusive, "*" for unbounded) on the average lhs degree, the
+fraction of lhs nodes with at most SMALL_DEGREE incident arcs, the
+maximum absolute arc cost, the number of nodes, and the ratio of lhs
+to rhs nodes. The last three fields give the scale factor, the global
+update frequency factor, and the strong price-out threshold; "-"
+leaves the variant's default in place. script/train-tune builds such
+tables from benchmark runs on the local machine.
+*/
+
+#define	TUNE_TABLE	"csa_tune.tab"
+#define	SMALL_DEGREE	4
+#define	NUM_FEATURES	5
+#define	MAX_VARIANT	40
+
+#ifndef	AUTO_SELF
+#define	AUTO_SELF	"csa_s_qm"
+#endif
+
+static	char	*builtin_table[] =
+{
+"# deg      small    cost        n         bal  variant       scale upd po",
+"  32:*     *:*      *:*         *:*       *:*  csa_s_qm      10    -   -",
+"  *:32     *:*      *:*         *:*       *:*  csa_s         10    -   -",
+NULL
+};
+
+typedef	struct	tune_row	{
+				double	lo[NUM_FEATURES], hi[NUM_FEATURES];
+				char	variant[MAX_VARIANT];
+				double	scale, upd_fac, po_thresh;
+				}	tune_row;
+
+extern	unsigned	n, m;
+extern	lhs_ptr		head_lhs_node, tail_lhs_node;
+extern	rhs_ptr		head_rhs_node, tail_rhs_node;
+extern	double		epsilon, scale_factor, po_cost_thresh;
+extern	char		*banner;
+extern	void		describe_self();
+#ifdef	USE_P_UPDATE
+extern	WORK_TYPE	upd_work_thresh;
+#endif
+
+/*
+Parse one range token "lo:hi". Return FALSE if it's malformed.
+*/
+
+static	int	parse_range(tok, lo, hi)
+
+char	*tok;
+double	*lo, *hi;
+
+{
+char	*colon;
+
+if ((colon = strchr(tok, ':')) == NULL)
+  return(FALSE);
+*colon = '\0';
+if (strcmp(tok, "*") == 0)
+  *lo = -HUGE_VAL;
+else if (sscanf(tok, "%lg", lo) != 1)
+  return(FALSE);
+if (strcmp(colon + 1, "*") == 0)
+  *hi = HUGE_VAL;
+else if (sscanf(colon + 1, "%lg", hi) != 1)
+  return(FALSE);
+return(TRUE);
+}
+
+static	int	parse_param(tok, val)
+
+char	*tok;
+double	*val;
+
+{
+if (strcmp(tok, "-") == 0)
+  {
+  *val = -1.0;
+  return(TRUE);
+  }
+return(sscanf(tok, "%lg", val) == 1);
+}
+
+/*
+Parse a table line into row. Return FALSE for comments, blank lines,
+and lines we can't make sense of.
+*/
+
+static	int	parse_row(line, row)
+
+char		*line;
+tune_row	*row;
+
+{
+char	buf[MAXLINE * 2], *tok[NUM_FEATURES + 4];
+int	i;
+
+(void) strncpy(buf, line, sizeof(buf) - 1);
+buf[sizeof(buf) - 1] = '\0';
+for (i = 0; i < NUM_FEATURES + 4; i++)
+  if ((tok[i] = strtok(i ? NULL : buf, " \t\n")) == NULL)
+    return(FALSE);
+if (tok[0][0] == '#')
+  return(FALSE);
+for (i = 0; i < NUM_FEATURES; i++)
+  if (!parse_range(tok[i], &row->lo[i], &row->hi[i]))
+    return(FALSE);
+if (strlen(tok[NUM_FEATURES]) >= MAX_VARIANT ||
+    strspn(tok[NUM_FEATURES], "abcdefghijklmnopqrstuvwxyz_") !=
+    strlen(tok[NUM_FEATURES]))
+  return(FALSE);
+(void) strcpy(row->variant, tok[NUM_FEATURES]);
+return(parse_param(tok[NUM_FEATURES + 1], &row->scale) &&
+       parse_param(tok[NUM_FEATURES + 2], &row->upd_fac) &&
+       parse_param(tok[NUM_FEATURES + 3], &row->po_thresh));
+}
+
+static	int	row_matches(row, feat)
+
+tune_row	*row;
+double		feat[];
+
+{
+int	i;
+
+for (i = 0; i < NUM_FEATURES; i++)
+  if ((feat[i] < row->lo[i]) || (feat[i] >= row->hi[i]))
+    return(FALSE);
+return(TRUE);
+}
+
+/*
+Find the first row of the decision table that matches feat, among the
+rows for variant if it isn't NULL. Return FALSE if none does.
+*/
+
+static	int	lookup(feat, variant, row)
+
+double		feat[];
+char		*variant;
+tune_row	*row;
+
+{
+FILE	*f;
+char	line[MAXLINE * 2];
+int	i;
+
+if ((f = fopen(TUNE_TABLE, "r")))
+  {
+  while (fgets(line, sizeof(line), f) != NULL)
+    if (parse_row(line, row) && row_matches(row, feat) &&
+	((variant == NULL) || (strcmp(row->variant, variant) == 0)))
+      {
+      (void) fclose(f);
+      return(TRUE);
+      }
+  (void) fclose(f);
+  }
+for (i = 0; builtin_table[i]; i++)
+  if (parse_row(builtin_table[i], row) && row_matches(row, feat) &&
+      ((variant == NULL) || (strcmp(row->variant, variant) == 0)))
+    return(TRUE);
+return(FALSE);
+}
+
+/*
+Compute the instance features: average lhs degree, fraction of
+small-degree lhs nodes, maximum absolute cost (parse() returns it as
+the initial epsilon), number of nodes, and lhs/rhs balance.
+*/
+
+static	void	inst_stats(feat)
+
+double	feat[];
+
+{
+lhs_ptr	v;
+unsigned	small = 0;
+long	lhs_n = tail_lhs_node - head_lhs_node;
+
+for (v = head_lhs_node; v != tail_lhs_node; v++)
+  if ((v+1)->priced_out - v->priced_out <= SMALL_DEGREE)
+    small++;
+feat[0] = (double) m / (double) lhs_n;
+feat[1] = (double) small / (double) lhs_n;
+feat[2] = epsilon;
+feat[3] = (double) n;
+feat[4] = (double) lhs_n / (double) (tail_rhs_node - head_rhs_node);
+}
+
+/*
+Hand the input to the executable for variant, in the same directory
+as our own executable (see sibling.c). Return only if that's
+impossible.
+*/
+
+static	void	run_variant(row, argv0)
+
+tune_row	*row;
+char		*argv0;
+
+{
+char	path[PATH_MAX], args[3][40], *new_argv[6];
+int	i = 0;
+int	sibling_path();
+
+if (lseek(fileno(stdin), 0L, SEEK_SET) != 0)
+  return;
+if (!sibling_path(row->variant, argv0, path))
+  {
+  (void) fprintf(stderr, "csa_auto: can't execute %s, so solving as %s\n",
+		 row->variant, AUTO_SELF);
+  return;
+  }
+
+new_argv[i++] = path;
+(void) snprintf(args[0], sizeof(args[0]), "%lg",
+		row->scale > 0.0 ? row->scale : (double) DEFAULT_SCALE_FACTOR);
+new_argv[i++] = args[0];
+if (strstr(row->variant, "_pu"))
+  {
+  (void) snprintf(args[1], sizeof(args[1]), "%lg",
+		  row->upd_fac > 0.0 ? row->upd_fac : (double) DEFAULT_UPD_FAC);
+  new_argv[i++] = args[1];
+  }
+if (strstr(row->variant, "spo") && (row->po_thresh > 0.0))
+  {
+  (void) snprintf(args[2], sizeof(args[2]), "%lg", row->po_thresh);
+  new_argv[i++] = args[2];
+  }
+new_argv[i] = NULL;
+
+(void) fflush(stdout);
+(void) execv(path, new_argv);
+(void) fprintf(stderr, "csa_auto: can't execute %s, so solving as %s\n",
+	       path, AUTO_SELF);
+}
+
+void	auto_tune(argc, argv)
+
+unsigned	argc;
+char		*argv[];
+
+{
+double		feat[NUM_FEATURES];
+tune_row	row;
+int		found;
+char		chosen[MAX_VARIANT];
+
+inst_stats(feat);
+found = lookup(feat, NULL, &row);
+
+/*
+Parameters given on the command line take precedence over the table.
+Only the process that solves the instance describes itself and its
+selection, so a hand-over leaves the variant's own header alone. If
+we solve the instance ourselves although the table chose another
+variant, we take the parameters from the best row for our own.
+*/
+chosen[0] = '\0';
+if (found && (strcmp(row.variant, AUTO_SELF) != 0))
+  {
+  (void) strcpy(chosen, row.variant);
+  if (argc <= 1)
+    run_variant(&row, argv[0]);
+  found = lookup(feat, AUTO_SELF, &row);
+  }
+
+describe_self();
+(void) puts(banner);
+if (!found && !chosen[0])
+  return;
+(void) printf("|>  auto: deg %.1f, small %.2f, max_cost %.0f, bal %.2f -> %s",
+	      feat[0], feat[1], feat[2], feat[4], AUTO_SELF);
+if (chosen[0])
+  (void) printf(" (table chose %s)", chosen);
+(void) putchar('\n');
+if (!found || (argc > 1))
+  return;
+
+if (row.scale > 0.0)
+  scale_factor = row.scale;
+#ifdef	USE_P_UPDATE
+if (row.upd_fac > 0.0)
+  upd_work_thresh = (unsigned) (row.upd_fac * (double) n);
+#endif
+#ifdef	STRONG_PO
+if (row.po_thresh > 0.0)
+  po_cost_thresh = row.po_thresh;
+#else
+po_cost_thresh = 2.0 * (double) n * (scale_factor + 1);
+#endif
+}
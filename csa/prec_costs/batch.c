@@ -0,0 +1,374 @@
+#include	<stdio.h>
+#include	<stdlib.h>
+#include	<string.h>
+#include	<unistd.h>
+#include	<sys/types.h>
+#include	<sys/time.h>
+#include	<sys/wait.h>
+#include	<sys/mman.h>
+#include	"csa_types.h"
+#include	"csa_defs.h"
+
+/*
+Solution of a stream of concatenated instances, each beginning with
+its problem line. The whole stream is read first and split into
+instances. As in components.c, the solver keeps its state in globals,
+so the workers are separate processes: num_threads of them are forked,
+and each takes the next unsolved instance from a count in shared
+memory until none are left. A worker keeps its solver's arrays from one
+instance to the next (see parse_alloc() in parse.c and init() in
+main.c), so it pays neither for a process start nor, mostly, for
+allocation. Each worker writes its reports, and its matchings in the
+SAVE_RESULT case, to files of its own. Where each instance's report
+and matching lie in those files is kept in shared memory, so that once
+the workers are through we can copy them out in input order. A worker
+that dies on a bad instance is replaced, and the instance is reported
+as failed.
+*/
+
+#define	NOT_STARTED	0
+#define	RUNNING		1
+#define	DONE		2
+#define	FAILED		3
+
+extern	unsigned	num_threads;
+extern	char		*banner;
+extern	void		parse_cmdline(), solve();
+
+extern	PAR_LOCAL unsigned	double_pushes, pushes, relabelings, refines,
+				refine_time;
+#ifdef	USE_P_REFINE
+extern	unsigned	p_refines, r_scans, p_refine_time;
+#endif
+#ifdef	USE_P_UPDATE
+extern	unsigned	p_updates, u_scans, p_update_time;
+#endif
+#ifdef	USE_SP_AUG
+extern	unsigned	sp_augs, a_scans, sp_aug_time;
+#endif
+#ifdef	STRONG_PO
+extern	unsigned	fix_ins;
+#endif
+#ifdef	QUICK_MIN
+extern	PAR_LOCAL unsigned	rebuilds, scans, non_scans;
+#endif
+#ifdef	EXPLICIT_LHS_PRICES
+extern	unsigned	unnec_rel;
+#endif
+#ifdef	BATCH_REFINE
+extern	unsigned	batches, batch_conflicts;
+#endif
+
+FILE	*batch_in;		/* the instance being parsed */
+FILE	*batch_flow;		/* where its matching goes */
+
+/*
+Where the report and the matching of an instance lie in the files of
+the worker that solved it.
+*/
+typedef	struct	inst_rec	{
+				int	state;
+				unsigned	worker;
+				long	out_start, out_end;
+				long	flow_start, flow_end;
+				}	*inst_ptr;
+
+static	char		*text;		/* the whole input stream */
+static	unsigned long	*inst_start;	/* offset of each instance */
+static	unsigned	num_inst;
+static	inst_ptr	inst;		/* shared */
+static	unsigned	*next_inst;	/* shared */
+static	FILE		**out_file, **flow_file;
+static	pid_t		*worker_pid;
+
+static	void	nomem()
+
+{
+void	exit();
+
+(void) printf("Can't obtain enough memory to solve this problem.\n");
+exit(9);
+}
+
+static	char	*shared_alloc(size)
+
+unsigned long	size;
+
+{
+char	*p;
+
+p = (char *) mmap(NULL, size ? size : 1, PROT_READ | PROT_WRITE,
+		  MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+if (p == (char *) MAP_FAILED)
+  nomem();
+return(p);
+}
+
+static	double	wall_clock()
+
+{
+struct timeval hold;
+
+(void) gettimeofday(&hold, (struct timezone *) 0);
+return((double) hold.tv_sec + (double) hold.tv_usec / 1e6);
+}
+
+/*
+Offset of the line after the one at offset i of text, len long.
+*/
+
+static	unsigned long	next_line(i, len)
+
+unsigned long	i, len;
+
+{
+char	*nl = (char *) memchr(text + i, '\n', len - i);
+
+return(nl ? nl - text + 1 : len);
+}
+
+/*
+Read the whole of the standard input, and find where each instance
+begins: at the start of the input for the first, and at its problem
+line for each later one, so comments between instances go with the
+instance before them, where the parser ignores them.
+*/
+
+static	void	read_stream()
+
+{
+unsigned long	len = 0, room = 1 << 16, i;
+size_t		got;
+int		seen_p = FALSE;
+
+if ((text = (char *) malloc(room)) == NULL)
+  nomem();
+while ((got = fread(text + len, 1, room - len, stdin)) > 0)
+  if ((len += got) == room)
+    if ((text = (char *) realloc(text, room *= 2)) == NULL)
+      nomem();
+
+num_inst = 0;
+for (i = 0; i < len; i = next_line(i, len))
+  if (text[i] == 'p')
+    {
+    if (seen_p)
+      num_inst++;
+    seen_p = TRUE;
+    }
+if (len > 0)
+  num_inst++;
+
+if ((inst_start = (unsigned long *) malloc((num_inst + 1) *
+					   sizeof(unsigned long))) == NULL)
+  nomem();
+inst_start[0] = 0;
+num_inst = 0;
+seen_p = FALSE;
+for (i = 0; i < len; i = next_line(i, len))
+  if (text[i] == 'p')
+    {
+    if (seen_p)
+      inst_start[++num_inst] = i;
+    seen_p = TRUE;
+    }
+if (len > 0)
+  num_inst++;
+inst_start[num_inst] = len;
+}
+
+static	void	reset_counters()
+
+{
+double_pushes = pushes = relabelings = refines = refine_time = 0;
+#ifdef	USE_P_REFINE
+p_refines = r_scans = p_refine_time = 0;
+#endif
+#ifdef	USE_P_UPDATE
+p_updates = u_scans = p_update_time = 0;
+#endif
+#ifdef	USE_SP_AUG
+sp_augs = a_scans = sp_aug_time = 0;
+#endif
+#ifdef	STRONG_PO
+fix_ins = 0;
+#endif
+#ifdef	QUICK_MIN
+rebuilds = scans = non_scans = 0;
+#endif
+#ifdef	EXPLICIT_LHS_PRICES
+unnec_rel = 0;
+#endif
+#ifdef	BATCH_REFINE
+batches = batch_conflicts = 0;
+#endif
+}
+
+static	long	file_pos(f)
+
+FILE	*f;
+
+{
+(void) fflush(f);
+return((long) lseek(fileno(f), (off_t) 0, SEEK_CUR));
+}
+
+/*
+The body of worker w: solve instances until none are left.
+*/
+
+static	void	work(w, argc, argv)
+
+unsigned	w;
+int		argc;
+char		*argv[];
+
+{
+unsigned	i;
+
+(void) dup2(fileno(out_file[w]), 1);
+batch_flow = flow_file[w];
+while ((i = __sync_fetch_and_add(next_inst, 1)) < num_inst)
+  {
+  inst[i].worker = w;
+  inst[i].out_start = file_pos(stdout);
+  inst[i].flow_start = file_pos(batch_flow);
+  inst[i].state = RUNNING;
+  batch_in = fmemopen(text + inst_start[i],
+		      inst_start[i + 1] - inst_start[i], "r");
+  if (batch_in == NULL)
+    nomem();
+  reset_counters();
+  solve(argc, argv);
+  (void) fclose(batch_in);
+  inst[i].out_end = file_pos(stdout);
+  inst[i].flow_end = file_pos(batch_flow);
+  inst[i].state = DONE;
+  }
+_exit(0);
+}
+
+static	void	start_worker(w, argc, argv)
+
+unsigned	w;
+int		argc;
+char		*argv[];
+
+{
+void	exit();
+
+(void) fflush(stdout);
+if ((worker_pid[w] = fork()) < 0)
+  {
+  (void) printf("Can't create process.\n");
+  exit(9);
+  }
+if (worker_pid[w] == 0)
+  work(w, argc, argv);
+}
+
+/*
+Copy bytes start, ..., end - 1 of f to g.
+*/
+
+static	void	copy_out(f, start, end, g)
+
+FILE	*f, *g;
+long	start, end;
+
+{
+char	buf[1 << 14];
+ssize_t	got;
+
+while (start < end)
+  {
+  got = pread(fileno(f), buf,
+	      end - start < sizeof(buf) ? end - start : sizeof(buf),
+	      (off_t) start);
+  if (got <= 0)
+    break;
+  (void) fwrite(buf, 1, (size_t) got, g);
+  start += got;
+  }
+}
+
+void	solve_batch(argc, argv)
+
+int	argc;
+char	*argv[];
+
+{
+unsigned	w, i, alive, failed = 0;
+pid_t		pid;
+double		start;
+#ifdef	SAVE_RESULT
+FILE		*f;
+#endif
+
+parse_cmdline(argc, argv);
+start = wall_clock();
+read_stream();
+inst = (inst_ptr) shared_alloc((num_inst + 1) * sizeof(struct inst_rec));
+next_inst = (unsigned *) shared_alloc(sizeof(unsigned));
+out_file = (FILE **) malloc(num_threads * sizeof(FILE *));
+flow_file = (FILE **) malloc(num_threads * sizeof(FILE *));
+worker_pid = (pid_t *) malloc(num_threads * sizeof(pid_t));
+if ((out_file == NULL) || (flow_file == NULL) || (worker_pid == NULL))
+  nomem();
+for (w = 0; w < num_threads; w++)
+  if (((out_file[w] = tmpfile()) == NULL) ||
+      ((flow_file[w] = tmpfile()) == NULL))
+    nomem();
+
+for (w = 0; w < num_threads; w++)
+  start_worker(w, argc, argv);
+alive = num_threads;
+while ((alive > 0) && ((pid = wait((int *) NULL)) > 0))
+  {
+  for (w = 0; (w < num_threads) && (worker_pid[w] != pid); w++) ;
+  if (w == num_threads)
+    continue;
+  /*
+  A worker exits only when no instances are left, or when its
+  instance fails. Its report runs to the end of its file.
+  */
+  for (i = 0; i < num_inst; i++)
+    if ((inst[i].state == RUNNING) && (inst[i].worker == w))
+      {
+      inst[i].out_end = (long) lseek(fileno(out_file[w]), (off_t) 0,
+				     SEEK_END);
+      inst[i].flow_end = inst[i].flow_start;
+      inst[i].state = FAILED;
+      failed++;
+      }
+  if (*next_inst < num_inst)
+    start_worker(w, argc, argv);
+  else
+    alive--;
+  }
+
+for (i = 0; i < num_inst; i++)
+  {
+  copy_out(out_file[inst[i].worker], inst[i].out_start, inst[i].out_end,
+	   stdout);
+  if (inst[i].state != DONE)
+    (void) printf("|>   instance %u failed\n", i + 1);
+  }
+#ifdef	SAVE_RESULT
+f = fopen("output.flow", "w");
+for (i = 0; i < num_inst; i++)
+  {
+  (void) fprintf(f, "c instance %u\n", i + 1);
+  copy_out(flow_file[inst[i].worker], inst[i].flow_start, inst[i].flow_end,
+	   f);
+  }
+(void) fclose(f);
+#endif
+
+start = wall_clock() - start;
+(void) printf("|>   %u instances, %u failed, %u workers, %.3f seconds\n",
+	      num_inst, failed, num_threads, start);
+(void) printf("|>   %lg instances per second\n",
+	      start > 0.0 ? (double) num_inst / start : 0.0);
+(void) puts(banner);
+}
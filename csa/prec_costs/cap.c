@@ -0,0 +1,149 @@
+#include	<stdio.h>
+#include	"csa_types.h"
+#include	"csa_defs.h"
+
+/*
+Capacitated assignment, in which rhs node w may be matched to up to
+w->cap lhs nodes, without replicating w and its arcs w->cap times.
+The copies are there all the same, as the slots of w, each with a
+price and a mate of its own, but they share w's arcs. An lhs node
+prefers the slot of w with the highest price, which is kept on top of
+a heap, and w->p and w->matched are always those of the top slot, so
+find_adm() and the best lists see w as they would the best of its
+copies. A double push to w takes the top slot, evicting its mate and
+lowering its price, after which the heap is restored; so that v ends
+up epsilon-optimal with respect to w's other slots, too, double_push()
+bounds the gap by the difference between the top two slot prices.
+Slots left free when the lhs nodes have run out are raised by
+rect_settle(), as free rhs nodes are, but all the slots of a node rise
+together; see rect.c.
+*/
+
+extern	rhs_ptr	head_rhs_node, tail_rhs_node;
+
+/*
+Move the slot at position k of a heap of cap slots down to its place.
+*/
+
+static	void	sift_down(s, cap, k)
+
+slot_ptr	s;
+unsigned	cap, k;
+
+{
+struct	slot	t;
+unsigned	i;
+
+t = s[k];
+while ((i = 2 * k + 1) < cap)
+  {
+  if ((i + 1 < cap) && (s[i + 1].p > s[i].p))
+    i++;
+  if (s[i].p <= t.p)
+    break;
+  s[k] = s[i];
+  if (s[k].mate)
+    s[k].mate->slot = k;
+  k = i;
+  }
+s[k] = t;
+if (t.mate)
+  t.mate->slot = k;
+}
+
+/*
+Restore the heap of w's slots after the price of slot k has changed,
+and refresh w's matched and p from the top slot.
+*/
+
+void	cap_fix(w, k)
+
+rhs_ptr	w;
+unsigned	k;
+
+{
+slot_ptr	s = w->slots;
+struct	slot	t;
+
+t = s[k];
+while ((k > 0) && (s[(k - 1) / 2].p < t.p))
+  {
+  s[k] = s[(k - 1) / 2];
+  if (s[k].mate)
+    s[k].mate->slot = k;
+  k = (k - 1) / 2;
+  }
+s[k] = t;
+sift_down(s, w->cap, k);
+w->matched = s[0].mate;
+w->p = s[0].p;
+}
+
+/*
+Raise each slot of w priced below p to p, and refresh w's matched and
+p from the top slot.
+*/
+
+void	cap_raise(w, p)
+
+rhs_ptr	w;
+double	p;
+
+{
+unsigned	k;
+
+for (k = 0; k < w->cap; k++)
+  if (w->slots[k].p < p)
+    w->slots[k].p = p;
+for (k = w->cap / 2; k > 0; k--)
+  sift_down(w->slots, w->cap, k - 1);
+w->matched = w->slots[0].mate;
+w->p = w->slots[0].p;
+}
+
+/*
+Called by dp_apply() once it has matched w's top slot and lowered its
+price through w->matched and w->p.
+*/
+
+void	cap_push(w)
+
+rhs_ptr	w;
+
+{
+w->slots[0].mate = w->matched;
+w->slots[0].p = w->p;
+cap_fix(w, 0);
+}
+
+/*
+Price of w's second slot, for w->cap > 1.
+*/
+
+double	cap_second(w)
+
+rhs_ptr	w;
+
+{
+if ((w->cap > 2) && (w->slots[2].p > w->slots[1].p))
+  return(w->slots[2].p);
+return(w->slots[1].p);
+}
+
+/*
+Called by refine() to unmatch every slot.
+*/
+
+void	cap_clear()
+
+{
+rhs_ptr	w;
+unsigned	k;
+
+for (w = head_rhs_node; w != tail_rhs_node; w++)
+  {
+  for (k = 0; k < w->cap; k++)
+    w->slots[k].mate = NULL;
+  w->matched = NULL;
+  }
+}
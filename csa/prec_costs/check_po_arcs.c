@@ -13,66 +13,172 @@ extern	double		po_cost_thresh, epsilon;
 #ifdef	QUICK_MIN
 extern	void	best_build();
 #endif
+#ifdef	DEGREE_STATS
+extern	unsigned	deg_moves;
+#endif
 
-int	check_po_arcs()
+static	double	po_cutoff;
+
+#ifdef	PAR_CHECK_PO
+/*
+In the PAR_CHECK_PO case the sweep over lhs nodes is split among
+threads, each claiming a run of nodes at a time with par_claim_lhs().
+The nodes a thread unmatches because of fix-ins go on a list of its
+own; once the sweep is over, the lists are merged and the nodes made
+active in increasing order, as the serial sweep would have done. The
+moves of reverse arcs are deferred to par_rev_moves() as in
+update_epsilon().
+*/
+#include	<stdlib.h>
+
+extern	unsigned	num_threads;
+extern	void		par_run(), par_fold_counts();
+extern	lhs_ptr		par_claim_lhs();
+
+typedef	struct	fix_list	{
+				lhs_ptr		*v;
+				unsigned	n, size;
+				}	fix_list;
+
+static	fix_list	*fixed = NULL;
+
+#ifdef	STORE_REV_ARCS
+extern	void		par_rev_init(), par_rev_moves();
+
+#undef	price_in_rev
+#define	price_in_rev(a)		defer_rev(a, f_a, REV_IN)
+#endif
+#endif	/* PAR_CHECK_PO */
+
+/*
+Price in arcs incident to v as appropriate, and unmatch v if a fix-in
+occurs. Return TRUE if v was unmatched because of a fix-in; in the
+serial case, v has also been made active.
+*/
+
+static	int	check_node(v)
 
-{
 lhs_ptr	v;
+
+{
 lr_aptr	a, a_start, a_stop;
-int	one_priced_in, fix_this_node, fix_in = FALSE;
-double	match_rc, this_cost, v_price, this_price, po_cutoff, thresh,
-	fix_in_thresh;
+int	one_priced_in, fix_this_node = FALSE;
+double	match_rc, this_cost, v_price, this_price, thresh, fix_in_thresh;
 #ifdef	QUICK_MIN
 int	need_best_rebuild;
 #endif
 
-#ifdef	DEBUG
-(void) printf("Checking priced-out arcs. total_e=%lu\n", total_e);
+#ifdef	QUICK_MIN
+need_best_rebuild = FALSE;
 #endif
-
-po_cutoff = po_cost_thresh * epsilon;
-for (v = head_lhs_node; v != tail_lhs_node; v++)
+/*
+All routines that incorporate prices into stored costs must update
+stored costs of priced-out arcs so the following code correctly
+computes reduced costs of priced-out arcs. At the present time,
+there are no such routines.
+*/
+a_stop = (v+1)->priced_out;
+if ((a = v->matched))
   {
+  /*
+  Node v is matched. Price in any arcs not far costlier than the
+  matching arc, and if there are any such arcs, make sure the
+  matching arc is priced in, too.
+  */
+  a_start = v->first;
+  one_priced_in = (a_start != a_stop);
+  fix_this_node = FALSE;
+  match_rc = a->c - a->head->p;
+  thresh = match_rc + po_cutoff;
+  fix_in_thresh = match_rc - epsilon;
+  for (a = v->priced_out; a != v->first; a++)
+    if ((a != v->matched) && ((this_cost = a->c - a->head->p) < thresh))
+      {
+      price_in_unm_arc(v, a);
+      one_priced_in = TRUE;
+      if (this_cost < fix_in_thresh)
+	{
+	/*
+	Epsilon-optimality violated by priced-in arc.
+	*/
+	fix_this_node = TRUE;
+#ifdef	DEBUG
+	(void) printf("Fixing in arc (%ld, %ld)\n", v - head_lhs_node + 1,
+		      a->head - head_rhs_node + 1);
+#endif
+	}
 #ifdef	QUICK_MIN
-  need_best_rebuild = FALSE;
+      need_best_rebuild = TRUE;
 #endif
+      /*
+      If we priced in the last priced-out arc in the list,
+      a == v->first, and we need to keep a from advancing too far.
+      */
+      if (a == v->first) break;
+      }
+  /*
+  Now if matching arc is priced out and there is some arc now priced
+  in that has a reduced cost not far enough above that of the
+  matching arc, price in the matching arc. We already know this
+  condition on arcs we priced in, of course. Don't check them.
+  */
+  if (!v->matched->head->node_info.priced_in)
+    if (one_priced_in)
+      {
+      a = v->matched;
+      price_in_mch_arc(v, a);
+#ifdef	QUICK_MIN
+      need_best_rebuild = TRUE;
+#endif
+      }
+  /*
+  If a fix-in occurred on this node, unmatch it to preserve
+  epsilon-optimality.
+  */
+  if (fix_this_node)
+    {
+#ifdef	DEBUG
+    (void) printf("Fix-in -- unmatching (%ld, %ld)\n",
+		  v - head_lhs_node + 1,
+		  v->matched->head - head_rhs_node + 1);
+#endif
+    v->matched->head->matched = NULL;
+    v->matched = NULL;
+#ifndef	PAR_CHECK_PO
+    total_e++;
+    make_active(v);
+#endif
+    }
+  }
+else
+  {
   /*
-  All routines that incorporate prices into stored costs must update
-  stored costs of priced-out arcs so the following code correctly
-  computes reduced costs of priced-out arcs. At the present time,
-  there are no such routines.
+  Node v is unmatched. Price any arc in whose reduced cost is less
+  than po_cutoff above the minimum priced-in arc.
   */
-  a_stop = (v+1)->priced_out;
-  if ((a = v->matched))
+  a = v->first;
+  if (a != a_stop)
     {
-    /*
-    Node v is matched. Price in any arcs not far costlier than the
-    matching arc, and if there are any such arcs, make sure the
-    matching arc is priced in, too.
-    */
-    a_start = v->first;
-    one_priced_in = (a_start != a_stop);
-    fix_this_node = FALSE;
-    match_rc = a->c - a->head->p;
-    thresh = match_rc + po_cutoff;
-    fix_in_thresh = match_rc - epsilon;
+#ifdef	EXPLICIT_LHS_PRICES
+    v_price = v->p;
+#else
+    v_price = a->head->p - a->c;
+    for (a++; a != a_stop; a++)
+      if (v_price < (this_price = a->head->p - a->c))
+	v_price = this_price;
+#endif
     for (a = v->priced_out; a != v->first; a++)
-      if ((a != v->matched) && ((this_cost = a->c - a->head->p) < thresh))
+      if (v_price - (this_price = a->head->p - a->c) < po_cutoff)
 	{
 	price_in_unm_arc(v, a);
-	one_priced_in = TRUE;
-	if (this_cost < fix_in_thresh)
-	  {
-	  /*
-	  Epsilon-optimality violated by priced-in arc.
-	  */
-	  fix_in = TRUE;
-	  fix_this_node = TRUE;
-#ifdef	DEBUG
-	  (void) printf("Fixing in arc (%ld, %ld)\n", v - head_lhs_node + 1,
-			a->head - head_rhs_node + 1);
-#endif
-	  }
+	/*
+	If (this_price > v_price), we might have priced in some arcs
+	unnecessarily because the reduced costs of arcs incident to
+	v turn out to be higher than we thought. This is OK, but do
+	the right thing for the rest of the priced-out arcs.
+	*/
+	if (this_price > v_price)
+	  v_price = this_price;
 #ifdef	QUICK_MIN
 	need_best_rebuild = TRUE;
 #endif
@@ -82,92 +188,133 @@ for (v = head_lhs_node; v != tail_lhs_node; v++)
 	*/
 	if (a == v->first) break;
 	}
-    /*
-    Now if matching arc is priced out and there is some arc now priced
-    in that has a reduced cost not far enough above that of the
-    matching arc, price in the matching arc. We already know this
-    condition on arcs we priced in, of course. Don't check them.
-    */
-    if (!v->matched->head->node_info.priced_in)
-      if (one_priced_in)
-	{
-	a = v->matched;
-	price_in_mch_arc(v, a);
+    }
+  }
 #ifdef	QUICK_MIN
-	need_best_rebuild = TRUE;
+/*
+Make sure v->node_info.few_arcs reflects the priced-in degree of v.
+*/
+if (a_stop - v->first < NUM_BEST + 1)
+  v->node_info.few_arcs = TRUE;
+else
+  {
+  v->node_info.few_arcs = FALSE;
+  if (need_best_rebuild)
+    best_build(v);
+  }
 #endif
-	}
-    /*
-    If a fix-in occurred on this node, unmatch it to preserve
-    epsilon-optimality.
-    */
-    if (fix_this_node)
-      {
-#ifdef	DEBUG
-      (void) printf("Fix-in -- unmatching (%ld, %ld)\n",
-		    v - head_lhs_node + 1,
-		    v->matched->head - head_rhs_node + 1);
-#endif
-      v->matched->head->matched = NULL;
-      v->matched = NULL;
-      total_e++;
-      make_active(v);
-      }
-    }
-  else
-    {
-    /*
-    Node v is unmatched. Price any arc in whose reduced cost is less
-    than po_cutoff above the minimum priced-in arc.
-    */
-    a = v->first;
-    if (a != a_stop)
-      {
-#ifdef	EXPLICIT_LHS_PRICES
-      v_price = v->p;
-#else
-      v_price = a->head->p - a->c;
-      for (a++; a != a_stop; a++)
-	if (v_price < (this_price = a->head->p - a->c))
-	  v_price = this_price;
+#ifdef	DEGREE_KERNELS
+set_deg_class(v);
 #endif
-      for (a = v->priced_out; a != v->first; a++)
-	if (v_price - (this_price = a->head->p - a->c) < po_cutoff)
+return(fix_this_node);
+}
+
+#ifdef	PAR_CHECK_PO
+static	void	check_thread(id)
+
+unsigned	id;
+
+{
+lhs_ptr		v, v_stop;
+fix_list	*f = &fixed[id];
+void	exit();
+
+f->n = 0;
+while ((v = par_claim_lhs(&v_stop)) != NULL)
+  for (; v != v_stop; v++)
+    if (check_node(v))
+      {
+      if (f->n == f->size)
+	{
+	f->size = 2 * f->size + 16;
+	f->v = (lhs_ptr *) realloc((char *) f->v, f->size * sizeof(lhs_ptr));
+	if (f->v == NULL)
 	  {
-	  price_in_unm_arc(v, a);
-	  /*
-	  If (this_price > v_price), we might have priced in some arcs
-	  unnecessarily because the reduced costs of arcs incident to
-	  v turn out to be higher than we thought. This is OK, but do
-	  the right thing for the rest of the priced-out arcs.
-	  */
-	  if (this_price > v_price)
-	    v_price = this_price;
-#ifdef	QUICK_MIN
-	  need_best_rebuild = TRUE;
-#endif
-	  /*
-	  If we priced in the last priced-out arc in the list,
-	  a == v->first, and we need to keep a from advancing too far.
-	  */
-	  if (a == v->first) break;
+	  (void) printf("Can't obtain enough memory to solve this problem.\n");
+	  exit(9);
 	  }
+	}
+      f->v[f->n++] = v;
       }
-    }
-#ifdef	QUICK_MIN
-  /*
-  Make sure v->node_info.few_arcs reflects the priced-in degree of v.
-  */
-  if (a_stop - v->first < NUM_BEST + 1)
-    v->node_info.few_arcs = TRUE;
-  else
+par_fold_counts(id);
+}
+
+static	int	fix_cmp(p, q)
+
+lhs_ptr	*p, *q;
+
+{
+return(*p < *q ? -1 : (*p > *q));
+}
+#endif	/* PAR_CHECK_PO */
+
+int	check_po_arcs()
+
+{
+lhs_ptr		v;
+int		fix_in = FALSE;
+#ifdef	PAR_CHECK_PO
+unsigned	i, j, k;
+void	exit();
+#endif
+
+#ifdef	DEBUG
+(void) printf("Checking priced-out arcs. total_e=%lu\n", total_e);
+#endif
+
+po_cutoff = po_cost_thresh * epsilon;
+#ifdef	PAR_CHECK_PO
+if (fixed == NULL)
+  {
+  fixed = (fix_list *) calloc(num_threads, sizeof(fix_list));
+  if (fixed == NULL)
     {
-    v->node_info.few_arcs = FALSE;
-    if (need_best_rebuild)
-      best_build(v);
+    (void) printf("Can't obtain enough memory to solve this problem.\n");
+    exit(9);
     }
+  }
+#ifdef	STORE_REV_ARCS
+par_rev_init();
+#endif
+par_run(check_thread);
+#ifdef	STORE_REV_ARCS
+par_rev_moves();
 #endif
+/*
+Gather the unmatched nodes into the first list, in order.
+*/
+for (i = 1; i < num_threads; i++)
+  for (j = 0; j < fixed[i].n; j++)
+    {
+    if (fixed[0].n == fixed[0].size)
+      {
+      fixed[0].size = 2 * fixed[0].size + 16;
+      fixed[0].v = (lhs_ptr *) realloc((char *) fixed[0].v,
+				       fixed[0].size * sizeof(lhs_ptr));
+      if (fixed[0].v == NULL)
+	{
+	(void) printf("Can't obtain enough memory to solve this problem.\n");
+	exit(9);
+	}
+      }
+    fixed[0].v[fixed[0].n++] = fixed[i].v[j];
+    }
+k = fixed[0].n;
+if (k > 1)
+  qsort((char *) fixed[0].v, k, sizeof(lhs_ptr), fix_cmp);
+for (i = 0; i < k; i++)
+  {
+  v = fixed[0].v[i];
+  total_e++;
+  make_active(v);
   }
+if (k > 0)
+  fix_in = TRUE;
+#else	/* PAR_CHECK_PO */
+for (v = head_lhs_node; v != tail_lhs_node; v++)
+  if (check_node(v))
+    fix_in = TRUE;
+#endif	/* PAR_CHECK_PO */
 
 #ifdef	DEBUG
 (void) printf("Checked priced-out arcs. total_e=%lu\n", total_e);
@@ -0,0 +1,530 @@
+#include	<stdio.h>
+#include	<stdlib.h>
+#include	<math.h>
+#include	<unistd.h>
+#include	<sys/types.h>
+#include	<sys/wait.h>
+#include	<sys/mman.h>
+#include	"csa_types.h"
+#include	"csa_defs.h"
+
+/*
+Solution of an instance one connected component at a time; see
+order_components() in parse.c for the node layout. Components with at
+most SMALL_COMPONENT lhs nodes are solved directly by the Hungarian
+method. Each larger one gets a cost-scaling run of its own, with its
+own epsilon schedule starting from its own largest cost, and up to
+num_threads of them are solved at once. The solver keeps all its state
+in globals, so (as in portfolio.c) the concurrent solves are separate
+processes: each is forked with a copy of the problem, solves its
+component, and leaves the matching, the prices and its counts in
+memory it shares with us. With one thread, or only one large
+component, the large components are solved here, one after another.
+*/
+
+#define	HU_BIG		1e30	/* cost of a missing arc */
+#define	MAX_COUNTERS	24
+
+extern	unsigned	n, m;
+extern	lhs_ptr		head_lhs_node, tail_lhs_node;
+extern	rhs_ptr		head_rhs_node, tail_rhs_node;
+extern	double		epsilon, min_epsilon, scale_factor;
+extern	unsigned	num_threads;
+extern	unsigned	num_comps;
+extern	lhs_ptr		*comp_lhs;
+extern	rhs_ptr		*comp_rhs;
+extern	unsigned	myclock();
+extern	void		cost_scaling();
+
+extern	PAR_LOCAL unsigned	double_pushes, pushes, relabelings, refines,
+				refine_time;
+#ifdef	USE_P_REFINE
+extern	unsigned	p_refines, r_scans, p_refine_time;
+#endif
+#ifdef	USE_P_UPDATE
+extern	unsigned	p_updates, u_scans, p_update_time;
+extern	WORK_TYPE	upd_work_thresh;
+#endif
+#ifdef	USE_SP_AUG
+extern	unsigned	sp_augs, a_scans, sp_aug_time;
+#endif
+#ifdef	STRONG_PO
+extern	unsigned	fix_ins;
+extern	WORK_TYPE	po_work_thresh;
+#endif
+#ifdef	QUICK_MIN
+extern	PAR_LOCAL unsigned	rebuilds, scans, non_scans;
+#endif
+#ifdef	BATCH_REFINE
+extern	unsigned	batches, batch_conflicts;
+#endif
+#if	defined(USE_P_REFINE) || defined(USE_P_UPDATE) || defined(USE_SP_AUG)
+extern	rhs_ptr		*bucket;
+extern	long		num_buckets;
+#endif
+
+static	unsigned	*counter[MAX_COUNTERS];	/* counts kept by solves */
+static	unsigned	num_counters;
+static	unsigned	num_small = 0;		/* components solved directly */
+static	unsigned	small_time = 0;
+static	unsigned	*comp_time;		/* per component */
+
+/*
+Results of the forked solves: for each lhs node, the number of the
+rhs node it's matched to and the cost of the matching arc; for each
+rhs node, its price; and for each component, its counts.
+*/
+static	unsigned	*mate;
+static	double		*mate_c, *price;
+static	unsigned	*comp_counts;
+
+static	void	nomem()
+
+{
+void	exit();
+
+(void) printf("Can't obtain enough memory to solve this problem.\n");
+exit(9);
+}
+
+static	void	infeasible()
+
+{
+void	exit();
+
+(void) printf("Infeasible problem\n");
+exit(9);
+}
+
+static	char	*shared_alloc(size)
+
+unsigned long	size;
+
+{
+char	*p;
+
+p = (char *) mmap(NULL, size ? size : 1, PROT_READ | PROT_WRITE,
+		  MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+if (p == (char *) MAP_FAILED)
+  nomem();
+return(p);
+}
+
+static	void	list_counters()
+
+{
+unsigned	i = 0;
+
+counter[i++] = &refines;
+counter[i++] = &relabelings;
+counter[i++] = &double_pushes;
+counter[i++] = &pushes;
+counter[i++] = &refine_time;
+#ifdef	USE_P_REFINE
+counter[i++] = &p_refines;
+counter[i++] = &r_scans;
+counter[i++] = &p_refine_time;
+#endif
+#ifdef	USE_P_UPDATE
+counter[i++] = &p_updates;
+counter[i++] = &u_scans;
+counter[i++] = &p_update_time;
+#endif
+#ifdef	USE_SP_AUG
+counter[i++] = &sp_augs;
+counter[i++] = &a_scans;
+counter[i++] = &sp_aug_time;
+#endif
+#ifdef	STRONG_PO
+counter[i++] = &fix_ins;
+#endif
+#ifdef	QUICK_MIN
+counter[i++] = &rebuilds;
+counter[i++] = &scans;
+counter[i++] = &non_scans;
+#endif
+#ifdef	BATCH_REFINE
+counter[i++] = &batches;
+counter[i++] = &batch_conflicts;
+#endif
+num_counters = i;
+}
+
+/*
+Solve component c by the Hungarian method, on a dense cost matrix in
+which a missing arc costs HU_BIG and parallel arcs are represented by
+the cheapest of them. Rows are lhs nodes and columns rhs nodes, both
+numbered from one; column zero is a dummy.
+*/
+
+static	void	solve_small(c)
+
+unsigned	c;
+
+{
+static	double	cost[SMALL_COMPONENT * SMALL_COMPONENT];
+static	lr_aptr	arc[SMALL_COMPONENT * SMALL_COMPONENT];
+static	double	u[SMALL_COMPONENT + 1], pv[SMALL_COMPONENT + 1],
+		minv[SMALL_COMPONENT + 1];
+static	unsigned	row[SMALL_COMPONENT + 1], way[SMALL_COMPONENT + 1];
+static	char	used[SMALL_COMPONENT + 1];
+lhs_ptr		v, v0 = comp_lhs[c];
+rhs_ptr		w0 = comp_rhs[c];
+unsigned	k = comp_lhs[c + 1] - v0, i, j, i0, j0, j1;
+lr_aptr		a, a_stop, *cell;
+double		delta, cur;
+
+if (k != comp_rhs[c + 1] - w0)
+  infeasible();
+for (i = 0; i < k * k; i++)
+  {
+  cost[i] = HU_BIG;
+  arc[i] = NULL;
+  }
+for (v = v0; v != comp_lhs[c + 1]; v++)
+  {
+  a_stop = (v+1)->priced_out;
+  for (a = v->priced_out; a != a_stop; a++)
+    {
+    i = (v - v0) * k + (a->head - w0);
+    if ((arc[i] == NULL) || (a->c < cost[i]))
+      {
+      arc[i] = a;
+      cost[i] = a->c;
+      }
+    }
+  }
+
+for (j = 0; j <= k; j++)
+  {
+  u[j] = pv[j] = 0.0;
+  row[j] = 0;
+  }
+for (i = 1; i <= k; i++)
+  {
+  /*
+  Grow a shortest-path tree from row i over tight edges until it
+  reaches an unassigned column, then augment along the tree path.
+  */
+  row[0] = i;
+  j0 = 0;
+  for (j = 0; j <= k; j++)
+    {
+    minv[j] = HUGE_VAL;
+    used[j] = FALSE;
+    }
+  do
+    {
+    used[j0] = TRUE;
+    i0 = row[j0];
+    delta = HUGE_VAL;
+    j1 = 0;
+    for (j = 1; j <= k; j++)
+      if (!used[j])
+	{
+	cur = cost[(i0 - 1) * k + j - 1] - u[i0] - pv[j];
+	if (cur < minv[j])
+	  {
+	  minv[j] = cur;
+	  way[j] = j0;
+	  }
+	if (minv[j] < delta)
+	  {
+	  delta = minv[j];
+	  j1 = j;
+	  }
+	}
+    for (j = 0; j <= k; j++)
+      if (used[j])
+	{
+	u[row[j]] += delta;
+	pv[j] -= delta;
+	}
+      else
+	minv[j] -= delta;
+    j0 = j1;
+    }
+  while (row[j0] != 0);
+  do
+    {
+    j1 = way[j0];
+    row[j0] = row[j1];
+    j0 = j1;
+    }
+  while (j0);
+  }
+
+for (j = 1; j <= k; j++)
+  {
+  cell = &arc[(row[j] - 1) * k + j - 1];
+  if (*cell == NULL)
+    infeasible();
+  v = v0 + row[j] - 1;
+  v->matched = *cell;
+  (*cell)->head->matched = v;
+  (*cell)->head->p = pv[j];
+  }
+}
+
+/*
+Solve component c by cost scaling, making it the whole problem as far
+as the rest of the solver can tell.
+*/
+
+static	void	solve_slice(c)
+
+unsigned	c;
+
+{
+lhs_ptr		save_head_lhs = head_lhs_node, save_tail_lhs = tail_lhs_node,
+		v;
+rhs_ptr		save_head_rhs = head_rhs_node, save_tail_rhs = tail_rhs_node;
+unsigned	save_n = n, save_m = m, save_refines = refines;
+double		save_min_epsilon = min_epsilon;
+lr_aptr		a, a_stop;
+#ifdef	USE_P_UPDATE
+WORK_TYPE	save_upd = upd_work_thresh;
+#endif
+#ifdef	STRONG_PO
+WORK_TYPE	save_po = po_work_thresh;
+#endif
+#if	defined(USE_P_REFINE) || defined(USE_P_UPDATE) || defined(USE_SP_AUG)
+long		save_num_buckets = num_buckets, i;
+rhs_ptr		w;
+#endif
+
+head_lhs_node = comp_lhs[c];
+tail_lhs_node = comp_lhs[c + 1];
+head_rhs_node = comp_rhs[c];
+tail_rhs_node = comp_rhs[c + 1];
+if (tail_lhs_node - head_lhs_node != tail_rhs_node - head_rhs_node)
+  infeasible();
+n = (tail_lhs_node - head_lhs_node) + (tail_rhs_node - head_rhs_node);
+m = tail_lhs_node->priced_out - head_lhs_node->priced_out;
+/*
+Start from the largest cost in the component, as init() does for the
+whole problem.
+*/
+epsilon = 0.0;
+for (v = head_lhs_node; v != tail_lhs_node; v++)
+  {
+  a_stop = (v+1)->priced_out;
+  for (a = v->priced_out; a != a_stop; a++)
+    if (fabs(a->c) > epsilon)
+      epsilon = fabs(a->c);
+  }
+if (epsilon < 1.0)
+  epsilon = 1.0;
+min_epsilon = 2.0 / (double) (n + 1);
+#ifdef	USE_P_UPDATE
+upd_work_thresh = (WORK_TYPE) ((double) save_upd * n / save_n);
+#endif
+#ifdef	STRONG_PO
+po_work_thresh = (WORK_TYPE) ((double) save_po * n / save_n);
+#endif
+#if	defined(USE_P_REFINE) || defined(USE_P_UPDATE) || defined(USE_SP_AUG)
+/*
+Bucket lists end at tail_rhs_node, which has changed.
+*/
+num_buckets = scale_factor * n + 1;
+for (i = 0; i < num_buckets; i++)
+  bucket[i] = tail_rhs_node;
+for (w = head_rhs_node; w != tail_rhs_node; w++)
+  w->key = num_buckets;
+#endif
+/*
+update_epsilon() takes refines > 0 to mean every node is matched.
+*/
+refines = 0;
+
+cost_scaling(myclock());
+
+refines += save_refines;
+head_lhs_node = save_head_lhs;
+tail_lhs_node = save_tail_lhs;
+head_rhs_node = save_head_rhs;
+tail_rhs_node = save_tail_rhs;
+n = save_n;
+m = save_m;
+min_epsilon = save_min_epsilon;
+#ifdef	USE_P_UPDATE
+upd_work_thresh = save_upd;
+#endif
+#ifdef	STRONG_PO
+po_work_thresh = save_po;
+#endif
+#if	defined(USE_P_REFINE) || defined(USE_P_UPDATE) || defined(USE_SP_AUG)
+num_buckets = save_num_buckets;
+#endif
+}
+
+/*
+In a forked process, solve component c and leave the results where
+our parent can find them.
+*/
+
+static	void	solve_child(c)
+
+unsigned	c;
+
+{
+unsigned	i, *counts = comp_counts + c * num_counters;
+lhs_ptr		v;
+rhs_ptr		w;
+
+for (i = 0; i < num_counters; i++)
+  *counter[i] = 0;
+comp_time[c] = myclock();
+solve_slice(c);
+comp_time[c] = myclock() - comp_time[c];
+for (i = 0; i < num_counters; i++)
+  counts[i] = *counter[i];
+for (v = comp_lhs[c]; v != comp_lhs[c + 1]; v++)
+  {
+  mate[v - head_lhs_node] = v->matched->head - head_rhs_node;
+  mate_c[v - head_lhs_node] = v->matched->c;
+  }
+for (w = comp_rhs[c]; w != comp_rhs[c + 1]; w++)
+  price[w - head_rhs_node] = w->p;
+(void) fflush(stdout);
+_exit(0);
+}
+
+/*
+Install the results of component c's forked solve.
+*/
+
+static	void	collect(c)
+
+unsigned	c;
+
+{
+unsigned	i, *counts = comp_counts + c * num_counters;
+lhs_ptr		v;
+rhs_ptr		w;
+lr_aptr		a, a_stop;
+
+for (i = 0; i < num_counters; i++)
+  *counter[i] += counts[i];
+for (v = comp_lhs[c]; v != comp_lhs[c + 1]; v++)
+  {
+  w = head_rhs_node + mate[v - head_lhs_node];
+  a_stop = (v+1)->priced_out;
+  for (a = v->priced_out; a != a_stop; a++)
+    if ((a->head == w) && (a->c == mate_c[v - head_lhs_node]))
+      break;
+  v->matched = a;
+  w->matched = v;
+  }
+for (w = comp_rhs[c]; w != comp_rhs[c + 1]; w++)
+  w->p = price[w - head_rhs_node];
+}
+
+void	solve_components()
+
+{
+unsigned	c, num_large = 0, running = 0;
+int		status;
+pid_t		pid;
+void		exit();
+
+comp_time = (unsigned *) shared_alloc(num_comps * sizeof(unsigned));
+small_time -= myclock();
+for (c = 0; c < num_comps; c++)
+  if (comp_lhs[c + 1] - comp_lhs[c] <= SMALL_COMPONENT)
+    {
+    solve_small(c);
+    num_small++;
+    }
+  else
+    num_large++;
+small_time += myclock();
+
+if ((num_threads == 1) || (num_large == 1))
+  {
+  for (c = 0; c < num_comps; c++)
+    if (comp_lhs[c + 1] - comp_lhs[c] > SMALL_COMPONENT)
+      {
+      comp_time[c] = myclock();
+      solve_slice(c);
+      comp_time[c] = myclock() - comp_time[c];
+      }
+  return;
+  }
+
+list_counters();
+mate = (unsigned *) shared_alloc((tail_lhs_node - head_lhs_node) *
+				 sizeof(unsigned));
+mate_c = (double *) shared_alloc((tail_lhs_node - head_lhs_node) *
+				 sizeof(double));
+price = (double *) shared_alloc((tail_rhs_node - head_rhs_node) *
+				sizeof(double));
+comp_counts = (unsigned *) shared_alloc(num_comps * num_counters *
+					sizeof(unsigned));
+(void) fflush(stdout);
+for (c = 0; c <= num_comps; c++)
+  {
+  /*
+  Wait for a worker to finish if all are busy, or for all of them
+  once every component has been started.
+  */
+  while ((running == num_threads) || ((c == num_comps) && running))
+    {
+    if ((wait(&status) < 0) || !WIFEXITED(status) ||
+	(WEXITSTATUS(status) != 0))
+      {
+      (void) printf("A component solve failed.\n");
+      exit(9);
+      }
+    running--;
+    }
+  if ((c == num_comps) || (comp_lhs[c + 1] - comp_lhs[c] <= SMALL_COMPONENT))
+    continue;
+  if ((pid = fork()) < 0)
+    {
+    perror("fork");
+    exit(9);
+    }
+  if (pid == 0)
+    solve_child(c);
+  running++;
+  }
+for (c = 0; c < num_comps; c++)
+  if (comp_lhs[c + 1] - comp_lhs[c] > SMALL_COMPONENT)
+    collect(c);
+}
+
+/*
+Time spent solving components, summed over the concurrent solves.
+*/
+
+unsigned	comp_solve_time()
+
+{
+unsigned	c, t = small_time;
+
+for (c = 0; c < num_comps; c++)
+  if (comp_lhs[c + 1] - comp_lhs[c] > SMALL_COMPONENT)
+    t += comp_time[c];
+return(t);
+}
+
+void	display_components()
+
+{
+unsigned	c;
+
+(void) printf("|>   %u components, %u solved directly in %.3f seconds\n",
+	      num_comps, num_small, (double) small_time / 60.0);
+(void) printf("|>   %.3f seconds of component solves in all\n",
+	      (double) comp_solve_time() / 60.0);
+for (c = 0; c < num_comps; c++)
+  if (comp_lhs[c + 1] - comp_lhs[c] > SMALL_COMPONENT)
+    (void) printf("|>     component %u: %ld nodes, %ld arcs, %.3f seconds\n",
+		  c + 1,
+		  (long) ((comp_lhs[c + 1] - comp_lhs[c]) +
+			  (comp_rhs[c + 1] - comp_rhs[c])),
+		  (long) (comp_lhs[c + 1]->priced_out -
+			  comp_lhs[c]->priced_out),
+		  (double) comp_time[c] / 60.0);
+}
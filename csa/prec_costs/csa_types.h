@@ -4,6 +4,230 @@
 #define	NUM_BEST	3
 #endif
 
+#ifdef	DEGREE_KERNELS
+/*
+largest priced-in degree for which double_push() has a dedicated
+straight-line kernel; nodes of higher degree share one class.
+*/
+#define	MAX_KERNEL_DEG	4
+#endif
+#if	defined(DEGREE_STATS) && !defined(DEGREE_KERNELS)
+#error	DEGREE_STATS reports on the DEGREE_KERNELS classes; it requires DEGREE_KERNELS.
+#endif
+
+#if	defined(BATCH_REFINE) && !defined(BATCH_SIZE)
+#define	BATCH_SIZE	16
+#endif
+#if	defined(BATCH_REFINE) && defined(DEGREE_STATS)
+#error	DEGREE_STATS times individual double pushes; not with BATCH_REFINE.
+#endif
+
+#if	defined(WAVE_ORDER) || defined(PRICE_ORDER) || defined(LOCALITY_ORDER)
+#define	KEYED_ORDER
+#if	defined(QUEUE_ORDER) || \
+	(defined(WAVE_ORDER) + defined(PRICE_ORDER) + defined(LOCALITY_ORDER) > 1)
+#error	At most one active-node ordering may be selected.
+#endif
+#endif
+
+#ifdef	PAR_REFINE
+#define	USE_THREADS
+#if	defined(USE_PRICE_OUT) || defined(USE_P_UPDATE) || \
+	defined(USE_P_REFINE) || defined(USE_SP_AUG_FORWARD) || \
+	defined(USE_SP_AUG_BACKWARD) || defined(EXPLICIT_LHS_PRICES) || \
+	defined(BATCH_REFINE) || defined(KEYED_ORDER) || defined(QUEUE_ORDER) || \
+	defined(DEGREE_STATS)
+#error	PAR_REFINE supports only QUICK_MIN and DEGREE_KERNELS.
+#endif
+#endif
+
+#ifdef	DET_PAR_REFINE
+#define	USE_THREADS
+#if	defined(PAR_REFINE) || defined(USE_PRICE_OUT) || \
+	defined(USE_P_UPDATE) || defined(USE_P_REFINE) || \
+	defined(USE_SP_AUG_FORWARD) || defined(USE_SP_AUG_BACKWARD) || \
+	defined(EXPLICIT_LHS_PRICES) || defined(BATCH_REFINE) || \
+	defined(KEYED_ORDER) || defined(QUEUE_ORDER) || defined(DEGREE_STATS)
+#error	DET_PAR_REFINE supports only QUICK_MIN and DEGREE_KERNELS.
+#endif
+#endif
+
+#if	defined(WORK_STEALING) && !defined(PAR_REFINE)
+#error	WORK_STEALING is relevant only in the PAR_REFINE case.
+#endif
+
+#ifdef	PAR_UPDATE_EPS
+#define	USE_THREADS
+#if	!defined(USE_PRICE_OUT) || defined(DEGREE_STATS)
+#error	PAR_UPDATE_EPS requires USE_PRICE_OUT and excludes DEGREE_STATS.
+#endif
+#endif
+
+#ifdef	PAR_CHECK_PO
+#define	USE_THREADS
+#if	!defined(STRONG_PO) || defined(DEGREE_STATS)
+#error	PAR_CHECK_PO requires STRONG_PO and excludes DEGREE_STATS.
+#endif
+#endif
+
+#ifdef	PAR_P_UPDATE
+#define	USE_THREADS
+#if	!defined(USE_P_UPDATE) || defined(DEGREE_STATS)
+#error	PAR_P_UPDATE requires USE_P_UPDATE and excludes DEGREE_STATS.
+#endif
+#endif
+
+#ifdef	PAR_BEST_BUILD
+#define	USE_THREADS
+#if	!defined(QUICK_MIN) || defined(DEGREE_STATS)
+#error	PAR_BEST_BUILD requires QUICK_MIN and excludes DEGREE_STATS.
+#endif
+#endif
+
+#ifdef	COMPONENTS
+#define	USE_THREADS
+#ifndef	SMALL_COMPONENT
+#define	SMALL_COMPONENT	32
+#endif
+#if	defined(PAR_REFINE) || defined(DET_PAR_REFINE) || \
+	defined(PAR_UPDATE_EPS) || defined(PAR_CHECK_PO) || \
+	defined(PAR_P_UPDATE) || defined(AUTO_TUNE) || defined(DEGREE_STATS)
+#error	COMPONENTS excludes the multi-threaded phases, AUTO_TUNE and DEGREE_STATS.
+#endif
+#endif
+
+#ifdef	BATCH_MODE
+#define	USE_THREADS
+#if	defined(PAR_REFINE) || defined(DET_PAR_REFINE) || \
+	defined(PAR_UPDATE_EPS) || defined(PAR_CHECK_PO) || \
+	defined(PAR_P_UPDATE) || defined(PAR_BEST_BUILD) || \
+	defined(COMPONENTS) || defined(AUTO_TUNE) || defined(KEYED_ORDER) || \
+	defined(QUEUE_ORDER) || defined(DEGREE_STATS)
+#error	BATCH_MODE excludes the multi-threaded phases, COMPONENTS, AUTO_TUNE, orderings other than the stack, and DEGREE_STATS.
+#endif
+#endif
+
+#ifdef	PIPELINE_EPS
+#define	USE_THREADS
+#ifndef	PIPE_BLOCKS
+#define	PIPE_BLOCKS	8
+#endif
+#if	!defined(USE_PRICE_OUT) || defined(STRONG_PO) || \
+	defined(BACK_PRICE_OUT) || defined(USE_P_UPDATE) || \
+	defined(USE_P_REFINE) || defined(USE_SP_AUG_FORWARD) || \
+	defined(USE_SP_AUG_BACKWARD) || defined(EXPLICIT_LHS_PRICES) || \
+	defined(BATCH_REFINE) || defined(KEYED_ORDER) || \
+	defined(QUEUE_ORDER) || defined(PAR_REFINE) || \
+	defined(DET_PAR_REFINE) || defined(PAR_UPDATE_EPS) || \
+	defined(PAR_BEST_BUILD) || defined(COMPONENTS) || \
+	defined(BATCH_MODE) || defined(DEGREE_STATS)
+#error	PIPELINE_EPS requires USE_PRICE_OUT, and supports only QUICK_MIN and DEGREE_KERNELS besides.
+#endif
+#endif
+
+#if	defined(PAR_UPDATE_EPS) && defined(BACK_PRICE_OUT)
+/*
+Back price-outs change the arc lists of lhs nodes the price-out pass
+has yet to reach, so with them the pass stays serial. The thread
+count is still read from the command line, as for the other _pe
+builds.
+*/
+#undef	PAR_UPDATE_EPS
+#endif
+
+#if	defined(WARM_START) && \
+	(defined(EXPLICIT_LHS_PRICES) || defined(COMPONENTS) || \
+	 defined(BATCH_MODE))
+#error	WARM_START excludes EXPLICIT_LHS_PRICES, COMPONENTS and BATCH_MODE.
+#endif
+
+#if	defined(AUCTION) && \
+	((defined(USE_PRICE_OUT) && !defined(STRONG_PO)) || \
+	 defined(BACK_PRICE_OUT) || defined(USE_P_UPDATE) || \
+	 defined(USE_P_REFINE) || defined(USE_SP_AUG_FORWARD) || \
+	 defined(USE_SP_AUG_BACKWARD) || defined(EXPLICIT_LHS_PRICES) || \
+	 defined(QUICK_MIN) || defined(DEGREE_KERNELS) || \
+	 defined(BATCH_REFINE) || defined(PAR_REFINE) || \
+	 defined(DET_PAR_REFINE) || defined(PIPELINE_EPS) || \
+	 defined(PAR_CHECK_PO) || defined(KEYED_ORDER) || \
+	 defined(COMPONENTS) || defined(BATCH_MODE) || defined(WARM_START) || \
+	 defined(INCREMENTAL) || defined(RECT_ASSIGN) || defined(ANYTIME) || \
+	 defined(DEGREE_STATS))
+#error	AUCTION needs STRONG_PO with price-outs, and supports only the stack and queue orderings besides.
+#endif
+
+#if	defined(INIT_GREEDY) || defined(INIT_AUCTION) || defined(INIT_DUAL)
+#define	INIT_MATCH
+#if	defined(EXPLICIT_LHS_PRICES) || defined(COMPONENTS) || \
+	defined(BATCH_MODE) || defined(WARM_START) || defined(RECT_ASSIGN) || \
+	defined(INCREMENTAL)
+#error	The initializers exclude EXPLICIT_LHS_PRICES, COMPONENTS, BATCH_MODE, WARM_START, RECT_ASSIGN and INCREMENTAL.
+#endif
+#endif
+
+#if	defined(DYNAMIC_NODES) && !defined(INCREMENTAL)
+#define	INCREMENTAL
+#endif
+
+#ifdef	INCREMENTAL
+#ifndef	INCR_ROOM
+#define	INCR_ROOM	4
+#endif
+#define	INCR_DEAD	1e30	/* cost of an arc slot not in use */
+#if	(defined(USE_PRICE_OUT) && !defined(STRONG_PO)) || \
+	defined(BACK_PRICE_OUT) || defined(USE_P_UPDATE) || \
+	defined(USE_SP_AUG_FORWARD) || defined(USE_SP_AUG_BACKWARD) || \
+	defined(EXPLICIT_LHS_PRICES) || defined(PAR_REFINE) || \
+	defined(DET_PAR_REFINE) || defined(COMPONENTS) || defined(BATCH_MODE)
+#error	INCREMENTAL needs STRONG_PO with price-outs, and excludes reverse arcs, SP_AUG, EXPLICIT_LHS_PRICES, the parallel refines, COMPONENTS and BATCH_MODE.
+#endif
+#endif
+
+#if	defined(CAPACITY) && !defined(RECT_ASSIGN)
+#define	RECT_ASSIGN
+#endif
+
+#if	defined(IMPERFECT) && !defined(RECT_ASSIGN)
+#define	RECT_ASSIGN
+#endif
+
+#if	defined(RECT_ASSIGN) && \
+	(defined(USE_PRICE_OUT) || defined(USE_P_UPDATE) || \
+	 defined(USE_P_REFINE) || defined(USE_SP_AUG_FORWARD) || \
+	 defined(USE_SP_AUG_BACKWARD) || defined(EXPLICIT_LHS_PRICES) || \
+	 defined(BATCH_REFINE) || defined(PAR_REFINE) || \
+	 defined(DET_PAR_REFINE) || defined(PIPELINE_EPS) || \
+	 defined(COMPONENTS) || defined(BATCH_MODE) || defined(WARM_START) || \
+	 defined(INCREMENTAL))
+#error	RECT_ASSIGN supports only QUICK_MIN, DEGREE_KERNELS and the orderings.
+#endif
+
+#ifdef	ANYTIME
+#ifndef	ANYTIME_CHECK
+#define	ANYTIME_CHECK	1024	/* double pushes between clock readings */
+#endif
+#if	defined(RECT_ASSIGN) || defined(PIPELINE_EPS) || \
+	defined(COMPONENTS) || defined(BATCH_MODE) || defined(INCREMENTAL)
+#error	ANYTIME excludes RECT_ASSIGN, PIPELINE_EPS, COMPONENTS, BATCH_MODE and INCREMENTAL.
+#endif
+#endif
+
+#ifdef	DENSE_JV
+#define	DENSE_MAGIC	"DMAT"	/* first bytes of a cost matrix */
+#ifndef	DENSE_THRESH
+#define	DENSE_THRESH	0.5	/* fraction of pairs with arcs */
+#endif
+#ifndef	JV_BLOCK
+#define	JV_BLOCK	256	/* columns a kernel sweeps at once */
+#endif
+#if	defined(EXPLICIT_LHS_PRICES) || defined(COMPONENTS) || \
+	defined(BATCH_MODE) || defined(AUTO_TUNE) || defined(WARM_START) || \
+	defined(INCREMENTAL) || defined(RECT_ASSIGN) || defined(ANYTIME) || \
+	defined(INIT_MATCH) || defined(AUCTION)
+#error	DENSE_JV excludes EXPLICIT_LHS_PRICES, COMPONENTS, BATCH_MODE, AUTO_TUNE, WARM_START, INCREMENTAL, RECT_ASSIGN, ANYTIME, the initializers and AUCTION.
+#endif
+#endif
+
 #if	defined(USE_SP_AUG_FORWARD) || defined(USE_SP_AUG_BACKWARD)
 #ifndef	USE_SP_AUG
 #define	USE_SP_AUG
@@ -16,7 +240,7 @@
 #endif
 
 typedef	struct	lhs_node	{
-#if	defined(QUICK_MIN)
+#if	defined(QUICK_MIN) || defined(DEGREE_KERNELS)
 				struct	{
 					/*
 					flag used to indicate to
@@ -26,6 +250,15 @@ typedef	struct	lhs_node	{
 					*/
 #ifdef	QUICK_MIN
 					unsigned	few_arcs : 1;
+#endif
+#ifdef	DEGREE_KERNELS
+					/*
+					priced-in degree of this node,
+					or MAX_KERNEL_DEG + 1 if it's
+					larger than that. selects the
+					double_push() kernel.
+					*/
+					unsigned	deg_class : 3;
 #endif
 					}	node_info;
 #ifdef	QUICK_MIN
@@ -49,6 +282,15 @@ typedef	struct	lhs_node	{
 				price of this node.
 				*/
 				double	p;
+#endif
+#ifdef	IMPERFECT
+				/*
+				price of this node's null node, to
+				which it is joined by an implicit arc
+				of cost zero; being matched to it
+				stands for being left unmatched.
+				*/
+				double	null_p;
 #endif
 				/*
 				first arc in the arc array associated
@@ -78,9 +320,39 @@ typedef	struct	lhs_node	{
 #endif
 #ifdef	USE_SP_AUG_BACKWARD
 				struct	lr_arc	*aug_path;
+#endif
+#if	defined(KEYED_ORDER) || defined(PAR_REFINE)
+				/*
+				next node in the list of active
+				nodes containing this node.
+				*/
+				struct	lhs_node	*next_active;
+#endif
+#ifdef	CAPACITY
+				/*
+				position in the slot heap of the rhs
+				node this node is matched to of the
+				slot holding it.
+				*/
+				unsigned	slot;
 #endif
 				}	*lhs_ptr;
 
+#ifdef	CAPACITY
+/*
+One unit of an rhs node's capacity, with a price of its own. An rhs
+node's slots are kept in a heap with the highest price on top.
+*/
+typedef	struct	slot		{
+				/*
+				lhs node this slot is matched to;
+				NULL if the slot is free.
+				*/
+				lhs_ptr	mate;
+				double	p;
+				}	*slot_ptr;
+#endif
+
 typedef	struct	rhs_node	{
 				struct	{
 #ifdef	USE_P_REFINE
@@ -102,8 +374,16 @@ typedef	struct	rhs_node	{
 					}	node_info;
 				/*
 				lhs node this rhs node is matched to.
+				in the PAR_REFINE case, matched and p
+				are changed together by a single
+				double-width compare-and-swap, so they
+				must be adjacent and 16-byte aligned.
 				*/
+#ifdef	PAR_REFINE
+				lhs_ptr	matched __attribute__ ((aligned (16)));
+#else
 				lhs_ptr	matched;
+#endif
 				/*
 				price of this node.
 				*/
@@ -111,6 +391,32 @@ typedef	struct	rhs_node	{
 #ifdef	USE_SP_AUG_FORWARD
 				struct	lr_arc	*aug_path;
 #endif
+#ifdef	CAPACITY
+				/*
+				number of lhs nodes this node can be
+				matched to, and its slots, one per
+				unit. matched and p above are those
+				of the top slot.
+				*/
+				unsigned	cap;
+				struct	slot	*slots;
+#endif
+#ifdef	BATCH_REFINE
+				/*
+				number of the last batch of double
+				pushes in which this node's price
+				changed.
+				*/
+				unsigned	batch;
+#endif
+#ifdef	DET_PAR_REFINE
+				/*
+				lowest-addressed lhs node proposing
+				to this node in the current round of
+				double pushes.
+				*/
+				struct	lhs_node	*claim;
+#endif
 #if	defined(USE_P_REFINE) || defined(USE_P_UPDATE) || defined(USE_SP_AUG)
 				/*
 				number of epsilons of price change
@@ -124,6 +430,14 @@ typedef	struct	rhs_node	{
 				*/
 				struct	rhs_node	*prev, *next;
 #endif
+#ifdef	PAR_P_UPDATE
+				/*
+				bucket whose list this node is on in
+				p_update(); key may have been lowered
+				past it by another thread.
+				*/
+				long	listed;
+#endif
 #ifdef	STORE_REV_ARCS
 				/*
 				first back arc in the arc array
@@ -213,3 +527,97 @@ typedef	struct	queue_st	{
 				char		**end;
 				unsigned	max_size;
 				}	*queue;
+
+#ifdef	KEYED_ORDER
+typedef	struct	keyed_st	{
+				/*
+				The active set as an array of buckets,
+				each a list of lhs nodes linked
+				through their next_active fields. Which
+				bucket a node goes into and which
+				bucket the next node comes out of
+				depend on the ordering policy; see
+				active.c.
+				*/
+				struct	lhs_node	**bucket;
+				unsigned	num_buckets;
+				/*
+				bucket we're taking nodes from.
+				*/
+				unsigned	cur;
+#ifdef	LOCALITY_ORDER
+				/*
+				circular queue of the nonempty
+				buckets.
+				*/
+				unsigned	*ring;
+				unsigned	ring_head, ring_tail;
+#endif
+				}	*keyed;
+#endif
+
+#ifdef	PAR_REFINE
+/*
+the matched and p fields of an rhs node, and the top of a lock-free
+stack, each as a single double-width word for compare-and-swap.
+*/
+typedef	union	{
+		unsigned __int128	bits;
+		struct	{
+			struct	lhs_node	*matched;
+			double	p;
+			}	f;
+		}	rhs_state;
+
+typedef	union	{
+		unsigned __int128	bits;
+		struct	{
+			struct	lhs_node	*top;
+			unsigned long	tag;
+			}	f;
+		}	ts_head;
+
+typedef	struct	tstack_st	{
+				ts_head	head;
+				}	*tstack;
+#endif
+
+#ifdef	WORK_STEALING
+/*
+A Chase-Lev work-stealing deque of lhs nodes, owned by one thread,
+which pushes and pops at the bottom while other threads steal from
+the top. Each deque also holds its owner's steal and idle-time
+statistics. Deques are aligned to a cache line so that threads
+updating their own don't interfere with one another.
+*/
+typedef	struct	wsdeque_st	{
+				struct	lhs_node	**buf;
+				long	top, bottom;
+				unsigned	steals, steal_tries;
+				double	idle_time;
+				}	__attribute__ ((aligned (64))) wsdeque;
+
+typedef	struct	wsset_st	{
+				/*
+				one deque per thread.
+				*/
+				wsdeque		*dq;
+				unsigned	num;
+				/*
+				deque capacity minus one; capacity
+				is a power of two.
+				*/
+				unsigned long	mask;
+				/*
+				number of threads looking for work,
+				and number of threads through with
+				the current phase.
+				*/
+				unsigned	idle, done;
+				/*
+				where the next node activated outside
+				a parallel phase goes.
+				*/
+				unsigned	seed;
+				}	*wsset;
+#endif
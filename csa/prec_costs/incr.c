@@ -0,0 +1,1181 @@
+#include	<stdio.h>
+#include	<stdlib.h>
+#include	<string.h>
+#include	"csa_types.h"
+#include	"csa_defs.h"
+
+/*
+Incremental re-solution after small changes to a solved instance: arc
+costs changed, arcs inserted and arcs deleted. incr_set_arc() and
+incr_delete_arc() apply one change each, in input node numbers, and
+incr_resolve() brings the solution up to date again. incr_stream()
+drives them from the standard input, where the instance may be
+followed by batches of changes, each introduced by a line "u" and
+made up of lines "a tail head cost" (set the cost of the arc,
+inserting it if need be) and "d tail head" (delete the arc).
+
+parse() leaves INCR_ROOM dead arcs at the start of each lhs node's
+list, among its priced-out arcs, and an insertion takes one of them; a
+deletion kills the arc and prices it out. When a list has no room left
+the arc array is laid out again, with INCR_ROOM more dead arcs for each
+node that has none.
+
+The nodes a change touches are its lhs nodes. All their arcs are
+priced in again, since the reasons they were priced out may no longer
+hold, their best lists are rebuilt, and those whose matching arcs are
+no longer epsilon-optimal are unmatched. A refine would match them
+again at the final epsilon only through a price war of a great many
+small steps whenever a change is large, and scaling down again from
+the largest violation unsettles prices far from the changes. Instead
+each unmatched node is matched along a shortest augmenting path, found
+as in sp_aug_forward.c but with a heap in place of the buckets, since
+path lengths here are bounded by the changes rather than by a small
+multiple of epsilon. Lowering the price of each rhs node scanned by
+the amount its distance falls short of the path's length keeps every
+arc epsilon-optimal, and no other prices move. The search follows
+priced-out arcs too, so none of them can end up violated with no
+refine left to fix them in; a path may leave a matching arc priced
+out, which refine() allows for anyway.
+
+In the DYNAMIC_NODES case a batch may also add nodes, with lines
+"n id" (an lhs node) and "r id" (an rhs node), and remove them with
+their arcs, with lines "x id". Node numbers are then looked up in a
+table rather than computed, and a number may be used again once its
+node is gone. A removed lhs node's arcs die and its slot goes on a
+free list, to be taken by the next lhs node added, with the dead arcs
+as its room. A removed rhs node is retired: its price drops to
+-INCR_DEAD, which keeps every arc into it out of use, and its slot is
+freed only when the arc array is next laid out, since that is when
+those arcs are cleared away. When a free list is empty, that layout
+also grows the node array by a part of its size. A new rhs node is
+priced as high as the arcs the batch gives it from matched nodes allow
+without breaking their matches. Should the live nodes come to
+outnumber what the final epsilon guarantees optimality for, epsilon
+is lowered and the matches that no longer hold are repaired like any
+others.
+
+Deleting the last arc of a node is refused; otherwise, as with any
+input, the instance is assumed to remain feasible, with as many live
+lhs nodes as rhs nodes at the end of each batch.
+*/
+
+#define	UNREACHED	-1
+#define	SCANNED		-2
+
+#ifdef	DYNAMIC_NODES
+#define	arc_live(a)	(((a)->c < INCR_DEAD) && ((a)->head->p > -INCR_DEAD))
+#else
+#define	arc_live(a)	((a)->c < INCR_DEAD)
+#endif
+
+extern	unsigned	n, m;
+extern	lhs_ptr		head_lhs_node, tail_lhs_node;
+extern	rhs_ptr		head_rhs_node, tail_rhs_node;
+extern	lr_aptr		head_lr_arc, tail_lr_arc;
+extern	unsigned	in_id_offset;
+extern	int		in_swap, updates_follow;
+extern	unsigned	total_e;
+extern	ACTIVE_TYPE	active;
+extern	char		*st_pop(), *deq();
+extern	int		match_holds();
+extern	unsigned	myclock();
+extern	double		fine_clock(), compute_cost();
+extern	void		display_results();
+#ifdef	QUICK_MIN
+extern	void		best_build();
+#endif
+#ifdef	DYNAMIC_NODES
+extern	double		epsilon;
+#endif
+
+static	char		*touched_flag = NULL;
+static	lhs_ptr		*touched;
+static	unsigned	num_touched = 0;
+static	unsigned	batches = 0, regrows = 0, paths = 0, path_scans = 0;
+static	double		*latency = NULL;	/* of each batch, in seconds */
+static	unsigned	latency_room = 0;
+
+/*
+Shortest path search state, indexed by rhs node: the distance found so
+far, the arc and lhs node it was found through, and the node's place
+in the heap, or UNREACHED or SCANNED.
+*/
+static	double		*dist = NULL;
+static	lr_aptr		*via;
+static	lhs_ptr		*from;
+static	long		*pos;
+static	rhs_ptr		*heap, *scanned;
+static	long		heap_n, scanned_n;
+
+#ifdef	DYNAMIC_NODES
+/*
+Node numbers by slot, 0 for a slot not in use, and slots by node
+number: lhs slot i as i + 1 and rhs slot j as -(j + 1).
+*/
+static	unsigned long	*lhs_id = NULL, *rhs_id;
+static	long		*slot_of;
+static	unsigned long	id_room;
+static	unsigned	*lhs_free, *rhs_free;	/* free slots */
+static	unsigned	lhs_free_n = 0, rhs_free_n = 0;
+static	char		*retired;	/* rhs slots arcs may still lead to */
+static	unsigned	retired_n = 0;
+static	unsigned	*fresh;		/* rhs slots added this batch */
+static	unsigned	fresh_n = 0;
+static	unsigned	adds = 0, removes = 0, tightenings = 0;
+#endif
+
+static	void	nomem()
+
+{
+void	exit();
+
+(void) printf("Can't obtain enough memory to solve this problem.\n");
+exit(9);
+}
+
+static	char	*grow_array(p, size)
+
+char		*p;
+unsigned long	size;
+
+{
+if ((p = (char *) realloc(p, size ? size : 1)) == NULL)
+  nomem();
+return(p);
+}
+
+#ifdef	DYNAMIC_NODES
+/*
+Set up the node number tables from the input numbering.
+*/
+
+static	void	dyn_init()
+
+{
+unsigned long	i, lhs_n = tail_lhs_node - head_lhs_node,
+		rhs_n = tail_rhs_node - head_rhs_node;
+
+id_room = lhs_n + rhs_n + 1;
+lhs_id = (unsigned long *) grow_array((char *) NULL,
+				      lhs_n * sizeof(unsigned long));
+rhs_id = (unsigned long *) grow_array((char *) NULL,
+				      rhs_n * sizeof(unsigned long));
+slot_of = (long *) grow_array((char *) NULL, id_room * sizeof(long));
+lhs_free = (unsigned *) grow_array((char *) NULL, lhs_n * sizeof(unsigned));
+rhs_free = (unsigned *) grow_array((char *) NULL, rhs_n * sizeof(unsigned));
+retired = grow_array((char *) NULL, rhs_n);
+fresh = (unsigned *) grow_array((char *) NULL, rhs_n * sizeof(unsigned));
+slot_of[0] = 0;
+for (i = 0; i < lhs_n; i++)
+  {
+  lhs_id[i] = in_swap ? in_id_offset + i + 1 : i + 1;
+  slot_of[lhs_id[i]] = i + 1;
+  }
+for (i = 0; i < rhs_n; i++)
+  {
+  rhs_id[i] = in_swap ? i + 1 : in_id_offset + i + 1;
+  slot_of[rhs_id[i]] = -(long) (i + 1);
+  retired[i] = FALSE;
+  }
+}
+
+/*
+The node numbers of v and w, 0 for slots not in use.
+*/
+
+unsigned long	dyn_lhs_id(v)
+
+lhs_ptr	v;
+
+{
+if (lhs_id == NULL)
+  dyn_init();
+return(lhs_id[v - head_lhs_node]);
+}
+
+unsigned long	dyn_rhs_id(w)
+
+rhs_ptr	w;
+
+{
+if (lhs_id == NULL)
+  dyn_init();
+return(rhs_id[w - head_rhs_node]);
+}
+
+/*
+Find our nodes for the node numbers tail and head, whichever way round
+they come. Return FALSE if they aren't live nodes on opposite sides.
+*/
+
+static	int	map_ids(tail, head, v, w)
+
+unsigned long	tail, head;
+lhs_ptr		*v;
+rhs_ptr		*w;
+
+{
+long	t, h;
+
+if (lhs_id == NULL)
+  dyn_init();
+if ((tail >= id_room) || (head >= id_room))
+  return(FALSE);
+t = slot_of[tail];
+h = slot_of[head];
+if ((t < 0) && (h > 0))
+  {
+  t = h;
+  h = slot_of[tail];
+  }
+if ((t <= 0) || (h >= 0))
+  return(FALSE);
+*v = head_lhs_node + t - 1;
+*w = head_rhs_node - h - 1;
+return(TRUE);
+}
+#else
+/*
+Find our nodes for the input node numbers tail and head. Return FALSE
+if they aren't nodes of the instance on opposite sides.
+*/
+
+static	int	map_ids(tail, head, v, w)
+
+unsigned long	tail, head;
+lhs_ptr		*v;
+rhs_ptr		*w;
+
+{
+unsigned long	temp;
+
+head -= in_id_offset;
+if (in_swap)
+  {
+  temp = head;
+  head = tail;
+  tail = temp;
+  }
+if ((tail < 1) || (tail > tail_lhs_node - head_lhs_node) ||
+    (head < 1) || (head > tail_rhs_node - head_rhs_node))
+  return(FALSE);
+*v = head_lhs_node + tail - 1;
+*w = head_rhs_node + head - 1;
+return(TRUE);
+}
+#endif
+
+/*
+Note that v has changed, and price in all its live arcs, the matching
+arc first so the others don't move it out of the way of the loop.
+*/
+
+static	void	touch(v)
+
+lhs_ptr	v;
+
+{
+lr_aptr	a;
+
+if (touched_flag == NULL)
+  {
+  touched_flag = (char *) calloc(tail_lhs_node - head_lhs_node, sizeof(char));
+  touched = (lhs_ptr *) malloc((tail_lhs_node - head_lhs_node) *
+			       sizeof(lhs_ptr));
+  if ((touched_flag == NULL) || (touched == NULL))
+    nomem();
+  }
+if (touched_flag[v - head_lhs_node])
+  return;
+touched_flag[v - head_lhs_node] = TRUE;
+touched[num_touched++] = v;
+
+if ((a = v->matched) && (a < v->first))
+  price_in_mch_arc(v, a);
+for (a = v->first; a != v->priced_out; )
+  {
+  a--;
+  if (arc_live(a))
+    price_in_unm_arc(v, a);
+  }
+}
+
+#ifdef	DYNAMIC_NODES
+/*
+Add k free lhs slots with empty lists at the end of the lhs node
+array, which may move.
+*/
+
+static	void	grow_lhs(k)
+
+unsigned	k;
+
+{
+lhs_ptr		v;
+rhs_ptr		w;
+lr_aptr		end = tail_lhs_node->priced_out;
+unsigned	i, *at, lhs_n = tail_lhs_node - head_lhs_node,
+		rhs_n = tail_rhs_node - head_rhs_node;
+
+/*
+Note the places of the nodes the rhs nodes are matched to and of the
+touched nodes (lhs_n for none) while the old array is still there.
+*/
+at = (unsigned *) grow_array((char *) NULL,
+			      (rhs_n + num_touched) * sizeof(unsigned));
+for (w = head_rhs_node; w != tail_rhs_node; w++)
+  at[w - head_rhs_node] = w->matched ? w->matched - head_lhs_node : lhs_n;
+for (i = 0; i < num_touched; i++)
+  at[rhs_n + i] = touched[i] - head_lhs_node;
+
+head_lhs_node = (lhs_ptr) grow_array((char *) head_lhs_node,
+				     (lhs_n + k + 1) * sizeof(struct lhs_node));
+tail_lhs_node = head_lhs_node + lhs_n + k;
+for (w = head_rhs_node; w != tail_rhs_node; w++)
+  if (at[w - head_rhs_node] != lhs_n)
+    w->matched = head_lhs_node + at[w - head_rhs_node];
+for (i = 0; i < num_touched; i++)
+  touched[i] = head_lhs_node + at[rhs_n + i];
+(void) free((char *) at);
+if (touched_flag)
+  {
+  touched_flag = grow_array(touched_flag, lhs_n + k);
+  (void) memset(touched_flag + lhs_n, 0, k);
+  touched = (lhs_ptr *) grow_array((char *) touched,
+				   (lhs_n + k) * sizeof(lhs_ptr));
+  }
+lhs_id = (unsigned long *) grow_array((char *) lhs_id,
+				      (lhs_n + k) * sizeof(unsigned long));
+lhs_free = (unsigned *) grow_array((char *) lhs_free,
+				   (lhs_n + k) * sizeof(unsigned));
+
+for (v = head_lhs_node + lhs_n; v != tail_lhs_node + 1; v++)
+  {
+  (void) memset((char *) v, 0, sizeof(struct lhs_node));
+  v->priced_out = v->first = end;
+#ifdef	QUICK_MIN
+  v->node_info.few_arcs = TRUE;
+#endif
+  }
+/*
+Slots are taken from the top of a free list, so push the new ones in
+reverse to hand them out in order.
+*/
+for (i = lhs_n + k; i-- > lhs_n; )
+  {
+  lhs_id[i] = 0;
+  lhs_free[lhs_free_n++] = i;
+  }
+}
+
+/*
+Add k free rhs slots at the end of the rhs node array, which may move.
+*/
+
+static	void	grow_rhs(k)
+
+unsigned	k;
+
+{
+rhs_ptr		w;
+lr_aptr		a, a_stop = tail_lhs_node->priced_out;
+unsigned	i, *at, rhs_n = tail_rhs_node - head_rhs_node;
+
+/*
+Note the arcs' heads while the old array is still there.
+*/
+at = (unsigned *) grow_array((char *) NULL,
+			      (a_stop - head_lr_arc) * sizeof(unsigned));
+for (a = head_lr_arc; a != a_stop; a++)
+  at[a - head_lr_arc] = a->head - head_rhs_node;
+
+head_rhs_node = (rhs_ptr) grow_array((char *) head_rhs_node,
+				     (rhs_n + k + 1) * sizeof(struct rhs_node));
+tail_rhs_node = head_rhs_node + rhs_n + k;
+for (a = head_lr_arc; a != a_stop; a++)
+  a->head = head_rhs_node + at[a - head_lr_arc];
+(void) free((char *) at);
+rhs_id = (unsigned long *) grow_array((char *) rhs_id,
+				      (rhs_n + k) * sizeof(unsigned long));
+rhs_free = (unsigned *) grow_array((char *) rhs_free,
+				   (rhs_n + k) * sizeof(unsigned));
+retired = grow_array(retired, rhs_n + k);
+fresh = (unsigned *) grow_array((char *) fresh,
+				(rhs_n + k) * sizeof(unsigned));
+
+for (w = head_rhs_node + rhs_n; w != tail_rhs_node + 1; w++)
+  {
+  (void) memset((char *) w, 0, sizeof(struct rhs_node));
+  w->node_info.priced_in = TRUE;
+  }
+for (i = rhs_n + k; i-- > rhs_n; )
+  {
+  rhs_id[i] = 0;
+  retired[i] = FALSE;
+  rhs_free[rhs_free_n++] = i;
+  }
+/*
+The search arrays are indexed by rhs node; start them over.
+*/
+if (dist)
+  {
+  (void) free((char *) dist);
+  (void) free((char *) via);
+  (void) free((char *) from);
+  (void) free((char *) pos);
+  (void) free((char *) heap);
+  (void) free((char *) scanned);
+  dist = NULL;
+  }
+}
+#endif
+
+/*
+Lay out the arc array again, after adding lhs_more and rhs_more node
+slots in the DYNAMIC_NODES case. Each list becomes its dead arcs,
+INCR_ROOM of them if it has none, then its live priced-out arcs, then
+its live priced-in arcs. Arcs into retired rhs nodes die on the way,
+which frees those nodes' slots.
+*/
+
+static	void	regrow(lhs_more, rhs_more)
+
+unsigned	lhs_more, rhs_more;
+
+{
+lhs_ptr		v;
+lr_aptr		a, a_first, a_stop, new_arcs, b, matched;
+unsigned long	size = 0, dead;
+char		*rebuild;
+#ifdef	QUICK_MIN
+unsigned	i;
+#endif
+#ifdef	DYNAMIC_NODES
+unsigned	j;
+
+if (lhs_more)
+  grow_lhs(lhs_more);
+if (rhs_more)
+  grow_rhs(rhs_more);
+#endif
+
+/*
+A node whose priced-in arcs lose one needs its best list built again.
+*/
+if ((rebuild = (char *) malloc(tail_lhs_node - head_lhs_node)) == NULL)
+  nomem();
+for (v = head_lhs_node; v != tail_lhs_node; v++)
+  {
+  dead = 0;
+  rebuild[v - head_lhs_node] = FALSE;
+  a_stop = (v+1)->priced_out;
+  for (a = v->priced_out; a != a_stop; a++)
+    if (!arc_live(a))
+      {
+      dead++;
+      if (a >= v->first)
+	rebuild[v - head_lhs_node] = TRUE;
+      }
+  size += (a_stop - v->priced_out) + (dead ? 0 : INCR_ROOM);
+  }
+if ((new_arcs = (lr_aptr) malloc((size + 1) * sizeof(struct lr_arc))) == NULL)
+  nomem();
+
+b = new_arcs;
+for (v = head_lhs_node; v != tail_lhs_node; v++)
+  {
+  a_first = v->first;
+  a_stop = (v+1)->priced_out;
+  matched = NULL;
+  dead = 0;
+  for (a = v->priced_out; a != a_stop; a++)
+    if (!arc_live(a))
+      {
+      if (a->c < INCR_DEAD)
+	m--;
+      dead++;
+      }
+  a = v->priced_out;
+  v->priced_out = b;
+  for (dead = dead ? dead : INCR_ROOM; dead > 0; dead--, b++)
+    {
+    b->head = head_rhs_node;
+    b->c = INCR_DEAD;
+    }
+  for (; a != a_first; a++)
+    if (arc_live(a))
+      {
+      if (a == v->matched)
+	matched = b;
+      copy_lr_arc(a, b);
+      b++;
+      }
+  /*
+  Unless one of them died, the priced-in arcs keep their order, and
+  the best list its places among them.
+  */
+#ifdef	QUICK_MIN
+  if (!v->node_info.few_arcs && !rebuild[v - head_lhs_node])
+    for (i = 0; i < NUM_BEST; i++)
+      v->best[i] = b + (v->best[i] - a_first);
+#endif
+  v->first = b;
+  for (; a != a_stop; a++)
+    if (arc_live(a))
+      {
+      if (a == v->matched)
+	matched = b;
+      copy_lr_arc(a, b);
+      b++;
+      }
+  v->matched = matched;
+  }
+tail_lhs_node->priced_out = b;
+
+(void) free((char *) head_lr_arc);
+head_lr_arc = new_arcs;
+tail_lr_arc = new_arcs + size;
+
+for (v = head_lhs_node; v != tail_lhs_node; v++)
+  if (rebuild[v - head_lhs_node])
+    {
+#ifdef	QUICK_MIN
+    if ((v+1)->priced_out - v->first < NUM_BEST + 1)
+      v->node_info.few_arcs = TRUE;
+    else
+      {
+      v->node_info.few_arcs = FALSE;
+      best_build(v);
+      }
+#endif
+#ifdef	DEGREE_KERNELS
+    set_deg_class(v);
+#endif
+    }
+(void) free(rebuild);
+
+#ifdef	DYNAMIC_NODES
+for (j = 0; j < tail_rhs_node - head_rhs_node; j++)
+  if (retired[j])
+    {
+    retired[j] = FALSE;
+    rhs_free[rhs_free_n++] = j;
+    }
+retired_n = 0;
+#endif
+regrows++;
+}
+
+/*
+Set the cost of the arc from input node tail to input node head,
+inserting the arc if there isn't one. Return FALSE if the nodes are
+bad.
+*/
+
+int	incr_set_arc(tail, head, cost)
+
+unsigned long	tail, head;
+long		cost;
+
+{
+lhs_ptr	v;
+rhs_ptr	w;
+lr_aptr	a, a_stop;
+
+if (!map_ids(tail, head, &v, &w))
+  return(FALSE);
+touch(v);
+
+a_stop = (v+1)->priced_out;
+for (a = v->first; (a != a_stop) && (a->head != w); a++) ;
+if (a == a_stop)
+  {
+  /*
+  All v's priced-out arcs are dead now; bring one to life. One that
+  led to a retired rhs node was still counted.
+  */
+  if (v->first == v->priced_out)
+    regrow(0, 0);
+  a = --v->first;
+  if (a->c < INCR_DEAD)
+    m--;
+  a->head = w;
+  m++;
+  }
+#ifdef	MIN_COST
+a->c = (double) cost;
+#else
+a->c = (double) -cost;
+#endif
+return(TRUE);
+}
+
+/*
+Delete the arc from input node tail to input node head. Return FALSE
+if there is no such arc, or if it's the last one its lhs node has.
+*/
+
+int	incr_delete_arc(tail, head)
+
+unsigned long	tail, head;
+
+{
+lhs_ptr	v;
+rhs_ptr	w;
+lr_aptr	a, a_stop;
+
+if (!map_ids(tail, head, &v, &w))
+  return(FALSE);
+touch(v);
+
+a_stop = (v+1)->priced_out;
+for (a = v->first; (a != a_stop) && (a->head != w); a++) ;
+if ((a == a_stop) || (a_stop - v->first == 1))
+  return(FALSE);
+if (a == v->matched)
+  {
+  w->matched = NULL;
+  v->matched = NULL;
+  }
+a->c = INCR_DEAD;
+price_out_unm_arc(v, a);
+m--;
+return(TRUE);
+}
+
+#ifdef	DYNAMIC_NODES
+/*
+How many slots to add to a full node array of the given size.
+*/
+#define	grow_by(size)	((size) / 8 + 16)
+
+/*
+Add a node with number id, on the lhs if lhs is TRUE and otherwise on
+the rhs. Return FALSE if the number is in use.
+*/
+
+int	dyn_add_node(id, lhs)
+
+unsigned long	id;
+int		lhs;
+
+{
+lhs_ptr		v;
+rhs_ptr		w;
+unsigned	i, k;
+unsigned long	old_room;
+
+if (lhs_id == NULL)
+  dyn_init();
+if (id == 0)
+  return(FALSE);
+if (id >= id_room)
+  {
+  old_room = id_room;
+  id_room = 2 * id + 1;
+  slot_of = (long *) grow_array((char *) slot_of, id_room * sizeof(long));
+  (void) memset((char *) (slot_of + old_room), 0,
+		(id_room - old_room) * sizeof(long));
+  }
+if (slot_of[id] != 0)
+  return(FALSE);
+
+if (lhs)
+  {
+  if (lhs_free_n == 0)
+    regrow(grow_by(tail_lhs_node - head_lhs_node), 0);
+  i = lhs_free[--lhs_free_n];
+  v = head_lhs_node + i;
+  lhs_id[i] = id;
+  slot_of[id] = i + 1;
+  v->matched = NULL;
+  touch(v);
+  }
+else
+  {
+  /*
+  Clearing away the retired nodes may be enough, if there are many.
+  */
+  if (rhs_free_n == 0)
+    {
+    k = grow_by(tail_rhs_node - head_rhs_node);
+    regrow(0, retired_n >= k ? 0 : k);
+    }
+  i = rhs_free[--rhs_free_n];
+  w = head_rhs_node + i;
+  rhs_id[i] = id;
+  slot_of[id] = -(long) (i + 1);
+  w->matched = NULL;
+  w->node_info.priced_in = TRUE;
+  w->p = 0.0;
+  fresh[fresh_n++] = i;
+  }
+n++;
+adds++;
+return(TRUE);
+}
+
+/*
+Remove the node with number id, with its arcs. Return FALSE if there
+is no such node.
+*/
+
+int	dyn_remove_node(id)
+
+unsigned long	id;
+
+{
+lhs_ptr	v;
+rhs_ptr	w;
+lr_aptr	a, a_stop;
+long	s;
+
+if (lhs_id == NULL)
+  dyn_init();
+if ((id == 0) || (id >= id_room) || ((s = slot_of[id]) == 0))
+  return(FALSE);
+slot_of[id] = 0;
+
+if (s > 0)
+  {
+  v = head_lhs_node + s - 1;
+  if (v->matched)
+    {
+    v->matched->head->matched = NULL;
+    v->matched = NULL;
+    }
+  a_stop = (v+1)->priced_out;
+  for (a = v->priced_out; a != a_stop; a++)
+    if (a->c < INCR_DEAD)
+      {
+      a->c = INCR_DEAD;
+      m--;
+      }
+  v->first = a_stop;
+#ifdef	QUICK_MIN
+  v->node_info.few_arcs = TRUE;
+#endif
+  lhs_id[s - 1] = 0;
+  lhs_free[lhs_free_n++] = s - 1;
+  }
+else
+  {
+  w = head_rhs_node - s - 1;
+  if ((v = w->matched))
+    {
+    touch(v);
+    v->matched = NULL;
+    w->matched = NULL;
+    }
+  w->p = -INCR_DEAD;
+  rhs_id[-s - 1] = 0;
+  retired[-s - 1] = TRUE;
+  retired_n++;
+  }
+n--;
+removes++;
+return(TRUE);
+}
+
+/*
+Price each rhs node added this batch as high as the arcs into it from
+matched nodes allow. Only touched nodes can have such arcs.
+*/
+
+static	void	price_fresh()
+
+{
+lhs_ptr		v;
+rhs_ptr		w;
+lr_aptr		a, a_stop;
+unsigned	i;
+double		m_pref;
+
+for (i = 0; i < fresh_n; i++)
+  if (rhs_id[fresh[i]])
+    retired[fresh[i]] = 2;	/* as a mark */
+for (i = 0; i < num_touched; i++)
+  if ((v = touched[i])->matched)
+    {
+    m_pref = v->matched->c - v->matched->head->p;
+    a_stop = (v+1)->priced_out;
+    for (a = v->first; a != a_stop; a++)
+      if ((retired[(w = a->head) - head_rhs_node] == 2) &&
+	  (a->c - m_pref < w->p))
+	w->p = a->c - m_pref;
+    }
+for (i = 0; i < fresh_n; i++)
+  if (retired[fresh[i]] == 2)
+    retired[fresh[i]] = FALSE;
+fresh_n = 0;
+}
+
+/*
+Once the live nodes outgrow epsilon, lower it to leave room for as
+many again, and unmatch the nodes whose matches no longer hold.
+*/
+
+static	void	tighten()
+
+{
+lhs_ptr	v;
+
+if (epsilon <= 2.0 / (double) (n + 1))
+  return;
+epsilon = 1.0 / (double) (n + 1);
+tightenings++;
+for (v = head_lhs_node; v != tail_lhs_node; v++)
+  if (v->matched && !match_holds(v))
+    {
+    v->matched->head->matched = NULL;
+    v->matched = NULL;
+    total_e++;
+    make_active(v);
+    }
+}
+#endif
+
+static	void	sift_up(i)
+
+long	i;
+
+{
+rhs_ptr	w = heap[i];
+double	d = dist[w - head_rhs_node];
+long	j;
+
+for (; (i > 0) && (dist[heap[j = (i - 1) / 2] - head_rhs_node] > d); i = j)
+  {
+  heap[i] = heap[j];
+  pos[heap[i] - head_rhs_node] = i;
+  }
+heap[i] = w;
+pos[w - head_rhs_node] = i;
+}
+
+static	rhs_ptr	heap_pop()
+
+{
+rhs_ptr	top = heap[0], w = heap[--heap_n];
+double	d = dist[w - head_rhs_node];
+long	i = 0, j;
+
+while ((j = 2 * i + 1) < heap_n)
+  {
+  if ((j + 1 < heap_n) &&
+      (dist[heap[j + 1] - head_rhs_node] < dist[heap[j] - head_rhs_node]))
+    j++;
+  if (dist[heap[j] - head_rhs_node] >= d)
+    break;
+  heap[i] = heap[j];
+  pos[heap[i] - head_rhs_node] = i;
+  i = j;
+  }
+heap[i] = w;
+pos[w - head_rhs_node] = i;
+pos[top - head_rhs_node] = SCANNED;
+return(top);
+}
+
+/*
+Offer w distance d along arc a from u.
+*/
+
+static	void	reach(w, d, a, u)
+
+rhs_ptr	w;
+double	d;
+lr_aptr	a;
+lhs_ptr	u;
+
+{
+long	i = w - head_rhs_node;
+
+if (pos[i] == SCANNED)
+  return;
+if (pos[i] == UNREACHED)
+  {
+  pos[i] = heap_n;
+  heap[heap_n++] = w;
+  }
+else if (d >= dist[i])
+  return;
+dist[i] = d;
+via[i] = a;
+from[i] = u;
+sift_up(pos[i]);
+}
+
+/*
+Match the unmatched node v along a shortest augmenting path, and adjust
+prices to keep epsilon-optimality. Distances are partial reduced costs
+relative to each lhs node's matching arc, with the small negative ones
+epsilon-optimality allows taken as zero, as in a_scan().
+*/
+
+static	void	shortest_path(v)
+
+lhs_ptr	v;
+
+{
+rhs_ptr	w, x;
+lhs_ptr	u;
+lr_aptr	a, a_stop, old;
+double	m_pref, d, len;
+long	i, k;
+void	exit();
+
+if (dist == NULL)
+  {
+  k = tail_rhs_node - head_rhs_node;
+  dist = (double *) malloc(k * sizeof(double));
+  via = (lr_aptr *) malloc(k * sizeof(lr_aptr));
+  from = (lhs_ptr *) malloc(k * sizeof(lhs_ptr));
+  pos = (long *) malloc(k * sizeof(long));
+  heap = (rhs_ptr *) malloc(k * sizeof(rhs_ptr));
+  scanned = (rhs_ptr *) malloc(k * sizeof(rhs_ptr));
+  if ((dist == NULL) || (via == NULL) || (from == NULL) || (pos == NULL) ||
+      (heap == NULL) || (scanned == NULL))
+    nomem();
+  for (i = 0; i < k; i++)
+    pos[i] = UNREACHED;
+  }
+heap_n = scanned_n = 0;
+paths++;
+
+a_stop = (v+1)->priced_out;
+m_pref = INCR_DEAD;
+for (a = v->priced_out; a != a_stop; a++)
+  if (arc_live(a) && (a->c - a->head->p < m_pref))
+    m_pref = a->c - a->head->p;
+for (a = v->priced_out; a != a_stop; a++)
+  if (arc_live(a))
+    reach(a->head, a->c - a->head->p - m_pref, a, v);
+
+for (;;)
+  {
+  if (heap_n == 0)
+    {
+    (void) printf("Error: scanning failure\n");
+    exit(-1);
+    }
+  w = heap_pop();
+  scanned[scanned_n++] = w;
+  path_scans++;
+  if ((u = w->matched) == NULL)
+    break;
+  i = w - head_rhs_node;
+  m_pref = u->matched->c - w->p;
+  a_stop = (u+1)->priced_out;
+  for (a = u->priced_out; a != a_stop; a++)
+    if ((a != u->matched) && arc_live(a))
+      {
+      d = a->c - a->head->p - m_pref;
+      reach(a->head, d > 0.0 ? dist[i] + d : dist[i], a, u);
+      }
+  }
+
+len = dist[w - head_rhs_node];
+for (k = 0; k < scanned_n; k++)
+  {
+  x = scanned[k];
+  i = x - head_rhs_node;
+  x->p -= len - dist[i];
+  pos[i] = UNREACHED;
+  }
+for (k = 0; k < heap_n; k++)
+  pos[heap[k] - head_rhs_node] = UNREACHED;
+
+/*
+Augment, back from w to v.
+*/
+for (;;)
+  {
+  i = w - head_rhs_node;
+  u = from[i];
+  old = u->matched;
+  u->matched = via[i];
+  w->matched = u;
+  w->node_info.priced_in = (via[i] >= u->first);
+  if (old == NULL)
+    break;
+  w = old->head;
+  }
+}
+
+/*
+Bring the solution up to date with the changes made since the last
+call. Return the number of nodes that had to be unmatched.
+*/
+
+unsigned	incr_resolve()
+
+{
+lhs_ptr		v;
+unsigned	i, unmatched = 0;
+
+#ifdef	DYNAMIC_NODES
+price_fresh();
+#endif
+for (i = 0; i < num_touched; i++)
+  {
+  v = touched[i];
+  touched_flag[v - head_lhs_node] = FALSE;
+#ifdef	DYNAMIC_NODES
+  if (lhs_id[v - head_lhs_node] == 0)
+    continue;
+#endif
+#ifdef	QUICK_MIN
+  if ((v+1)->priced_out - v->first < NUM_BEST + 1)
+    v->node_info.few_arcs = TRUE;
+  else
+    {
+    v->node_info.few_arcs = FALSE;
+    best_build(v);
+    }
+#endif
+#ifdef	DEGREE_KERNELS
+  set_deg_class(v);
+#endif
+  if (v->matched && !match_holds(v))
+    {
+    v->matched->head->matched = NULL;
+    v->matched = NULL;
+    }
+  if (v->matched == NULL)
+    {
+    unmatched++;
+    total_e++;
+    make_active(v);
+    }
+  }
+num_touched = 0;
+#ifdef	DYNAMIC_NODES
+tighten();
+#endif
+
+while (total_e > 0)
+  {
+  get_active_node(v);
+  total_e--;
+  shortest_path(v);
+  }
+batches++;
+return(unmatched);
+}
+
+/*
+Apply the batches of changes that follow the instance on the standard
+input, reporting on each, and then on the final solution.
+*/
+
+void	incr_stream()
+
+{
+char		in_line[MAXLINE];
+unsigned long	tail, head;
+long		cost;
+unsigned	sets, dels, bad, unmatched, time, total_time = 0,
+		old_paths, old_scans;
+double		start;
+int		more = updates_follow;
+
+while (more)
+  {
+  time = myclock();
+  start = fine_clock();
+  old_paths = paths;
+  old_scans = path_scans;
+  sets = dels = bad = 0;
+  more = FALSE;
+  while (fgets(in_line, sizeof(in_line), stdin) != NULL)
+    {
+    if (in_line[0] == 'u')
+      {
+      more = TRUE;
+      break;
+      }
+    switch (in_line[0])
+      {
+      case 'a':
+	if ((sscanf(in_line, "%*c%lu%lu%ld", &tail, &head, &cost) == 3) &&
+	    incr_set_arc(tail, head, cost))
+	  sets++;
+	else
+	  bad++;
+	break;
+      case 'd':
+	if ((sscanf(in_line, "%*c%lu%lu", &tail, &head) == 2) &&
+	    incr_delete_arc(tail, head))
+	  dels++;
+	else
+	  bad++;
+	break;
+#ifdef	DYNAMIC_NODES
+      case 'n':
+      case 'r':
+	if ((sscanf(in_line, "%*c%lu", &tail) == 1) &&
+	    dyn_add_node(tail, in_line[0] == 'n'))
+	  sets++;
+	else
+	  bad++;
+	break;
+      case 'x':
+	if ((sscanf(in_line, "%*c%lu", &tail) == 1) && dyn_remove_node(tail))
+	  dels++;
+	else
+	  bad++;
+	break;
+#endif
+      case 'c':
+      case '\n':
+	break;
+      default:
+	bad++;
+	break;
+      }
+    }
+  unmatched = incr_resolve();
+  time = myclock() - time;
+  total_time += time;
+  if (batches > latency_room)
+    {
+    latency_room = 2 * batches;
+    latency = (double *) grow_array((char *) latency,
+				    latency_room * sizeof(double));
+    }
+  latency[batches - 1] = fine_clock() - start;
+  (void) printf("|>   update %u: %u set, %u deleted, %u rejected; %u unmatched, %u paths, %u scans\n",
+		batches, sets, dels, bad, unmatched, paths - old_paths,
+		path_scans - old_scans);
+  (void) printf("|>             cost %17.0f,    time %10.6f seconds\n",
+		compute_cost(), latency[batches - 1]);
+  }
+if (batches > 0)
+  display_results(total_time);
+}
+
+static	int	latency_cmp(p, q)
+
+double	*p, *q;
+
+{
+return((*p > *q) - (*p < *q));
+}
+
+void	display_incr()
+
+{
+if (batches == 0)
+  return;
+(void) printf("|>   %u update batches, %u augmenting paths, %u rhs scans, %u arc array layouts\n",
+	      batches, paths, path_scans, regrows);
+#ifdef	DYNAMIC_NODES
+(void) printf("|>   %u nodes added, %u removed, %u epsilon tightenings\n",
+	      adds, removes, tightenings);
+#endif
+qsort((char *) latency, batches, sizeof(double), latency_cmp);
+(void) printf("|>   update latency (ms): median %.3f, 90%% %.3f, 99%% %.3f, max %.3f\n",
+	      1e3 * latency[batches / 2], 1e3 * latency[batches * 9 / 10],
+	      1e3 * latency[batches * 99 / 100], 1e3 * latency[batches - 1]);
+}
@@ -0,0 +1,303 @@
+#include	<stdio.h>
+#include	<stdlib.h>
+#include	"csa_types.h"
+#include	"csa_defs.h"
+
+/*
+Heuristic initial matching and prices, so that scaling can start from
+a lower epsilon than the largest cost, skipping the early refines in
+which every lhs node starts unmatched. One of three initializers is
+compiled in:
+
+INIT_GREEDY	Rounds of proposals: every unmatched lhs node proposes
+		along its cheapest arc to a still unmatched rhs node,
+		and each rhs node takes the cheapest proposal it gets.
+		A round doesn't depend on the order in which the nodes
+		are taken. Prices stay zero, so the arcs matched in the
+		first round, each its node's cheapest, are optimal for
+		any epsilon; those of later rounds are not.
+
+INIT_AUCTION	Rounds of Gauss-Seidel auction bidding by the
+		unmatched lhs nodes at the epsilon of the first refine:
+		each takes the rhs node of least partial reduced cost,
+		evicting its mate, and lowers its price by the
+		difference from the second least plus epsilon, just as
+		a double push does.
+
+INIT_DUAL	Dual ascent over the column and row minima, as in the
+		initialization of Jonker and Volgenant's algorithm:
+		each rhs node is priced at its least incident cost and
+		matched along that arc if the lhs node is still free;
+		then each matched lhs node lowers its mate's price
+		until its second least partial reduced cost ties.
+		Every arc matched is optimal for any epsilon.
+
+Scaling starts from init_match()'s return, the first refine running
+at INIT_DIVISOR times less than the largest cost, and that refine
+keeps every arc of the initial matching that is epsilon-optimal, as
+it does those imported by WARM_START.
+*/
+
+extern	unsigned	n;
+extern	lhs_ptr		head_lhs_node, tail_lhs_node;
+extern	rhs_ptr		head_rhs_node, tail_rhs_node;
+extern	double		scale_factor;
+extern	double		fine_clock();
+extern	int		match_holds();
+
+static	unsigned	started = 0,	/* matching arcs we start with */
+			kept = 0;	/* and kept by the first refine */
+static	double		init_time, first_eps;
+
+#if	defined(INIT_GREEDY) || defined(INIT_DUAL)
+static	void	*init_alloc(size)
+
+unsigned long	size;
+
+{
+void	*p, exit();
+
+if ((p = malloc(size)) == NULL)
+  {
+  (void) printf("Error: no memory for the initial matching\n");
+  exit(9);
+  }
+return(p);
+}
+#endif
+
+#ifdef	INIT_GREEDY
+static	void	init_heuristic()
+
+{
+lhs_ptr	v;
+rhs_ptr	w;
+lr_aptr	a, a_stop, best, *choice, *prop;
+unsigned	round;
+int	proposed = TRUE;
+
+choice = (lr_aptr *) init_alloc((tail_lhs_node - head_lhs_node) *
+				sizeof(lr_aptr));
+prop = (lr_aptr *) init_alloc((tail_rhs_node - head_rhs_node) *
+			      sizeof(lr_aptr));
+for (w = head_rhs_node; w != tail_rhs_node; w++)
+  prop[w - head_rhs_node] = NULL;
+for (round = 0; proposed && (round < INIT_ROUNDS); round++)
+  {
+  proposed = FALSE;
+  for (v = head_lhs_node; v != tail_lhs_node; v++)
+    {
+    choice[v - head_lhs_node] = best = NULL;
+    if (v->matched)
+      continue;
+    a_stop = (v + 1)->priced_out;
+    for (a = v->first; a != a_stop; a++)
+      if ((a->head->matched == NULL) && ((best == NULL) || (a->c < best->c)))
+	best = a;
+    if (best)
+      {
+      choice[v - head_lhs_node] = best;
+      w = best->head;
+      if ((prop[w - head_rhs_node] == NULL) ||
+	  (best->c < prop[w - head_rhs_node]->c))
+	prop[w - head_rhs_node] = best;
+      proposed = TRUE;
+      }
+    }
+  for (v = head_lhs_node; v != tail_lhs_node; v++)
+    if ((best = choice[v - head_lhs_node]) &&
+	(prop[best->head - head_rhs_node] == best))
+      {
+      v->matched = best;
+      best->head->matched = v;
+      started++;
+      }
+  }
+free((char *) choice);
+free((char *) prop);
+}
+#endif
+
+#ifdef	INIT_AUCTION
+static	void	init_heuristic()
+
+{
+lhs_ptr	v, u;
+rhs_ptr	w;
+lr_aptr	a, a_stop, best;
+unsigned	round;
+double	red_cost, first, second;
+int	bid = TRUE, two;
+
+for (round = 0; bid && (round < INIT_ROUNDS); round++)
+  {
+  bid = FALSE;
+  for (v = head_lhs_node; v != tail_lhs_node; v++)
+    {
+    if (v->matched)
+      continue;
+    best = NULL;
+    two = FALSE;
+    first = second = 0.0;
+    a_stop = (v + 1)->priced_out;
+    for (a = v->first; a != a_stop; a++)
+      {
+      red_cost = a->c - a->head->p;
+      if (best == NULL)
+	{
+	first = red_cost;
+	best = a;
+	}
+      else if (red_cost < first)
+	{
+	second = first;
+	first = red_cost;
+	best = a;
+	two = TRUE;
+	}
+      else if (!two || (red_cost < second))
+	{
+	second = red_cost;
+	two = TRUE;
+	}
+      }
+    if (best == NULL)
+      continue;
+    if (!two)
+      second = first;
+    w = best->head;
+    if ((u = w->matched))
+      {
+      u->matched = NULL;
+      started--;
+      }
+    w->p -= second - first + first_eps;
+    v->matched = best;
+    w->matched = v;
+    started++;
+    bid = TRUE;
+    }
+  }
+}
+#endif
+
+#ifdef	INIT_DUAL
+static	void	init_heuristic()
+
+{
+lhs_ptr	v, *arg_v;
+rhs_ptr	w;
+lr_aptr	a, a_stop, *arg;
+double	red_cost, second;
+int	any;
+
+arg = (lr_aptr *) init_alloc((tail_rhs_node - head_rhs_node) *
+			     sizeof(lr_aptr));
+arg_v = (lhs_ptr *) init_alloc((tail_rhs_node - head_rhs_node) *
+			       sizeof(lhs_ptr));
+for (w = head_rhs_node; w != tail_rhs_node; w++)
+  arg[w - head_rhs_node] = NULL;
+/*
+Column reduction.
+*/
+for (v = head_lhs_node; v != tail_lhs_node; v++)
+  {
+  a_stop = (v + 1)->priced_out;
+  for (a = v->first; a != a_stop; a++)
+    {
+    w = a->head;
+    if ((arg[w - head_rhs_node] == NULL) || (a->c < arg[w - head_rhs_node]->c))
+      {
+      arg[w - head_rhs_node] = a;
+      arg_v[w - head_rhs_node] = v;
+      }
+    }
+  }
+for (w = head_rhs_node; w != tail_rhs_node; w++)
+  if ((a = arg[w - head_rhs_node]))
+    {
+    w->p = a->c;
+    if ((v = arg_v[w - head_rhs_node])->matched == NULL)
+      {
+      v->matched = a;
+      w->matched = v;
+      started++;
+      }
+    }
+/*
+Reduction transfer: the matching arcs have partial reduced cost zero
+and the others no less, so lowering the price of each matched rhs
+node by its mate's second least partial reduced cost leaves the mate
+indifferent, and every other lhs node less drawn to it.
+*/
+for (v = head_lhs_node; v != tail_lhs_node; v++)
+  if (v->matched)
+    {
+    any = FALSE;
+    second = 0.0;
+    a_stop = (v + 1)->priced_out;
+    for (a = v->first; a != a_stop; a++)
+      if (a != v->matched)
+	{
+	red_cost = a->c - a->head->p;
+	if (!any || (red_cost < second))
+	  second = red_cost;
+	any = TRUE;
+	}
+    v->matched->head->p -= second;
+    }
+free((char *) arg);
+free((char *) arg_v);
+}
+#endif
+
+/*
+Build the initial matching and prices, and return the epsilon from
+which to scale.
+*/
+
+double	init_match(max_cost)
+
+double	max_cost;
+
+{
+double	start;
+
+first_eps = max_cost / INIT_DIVISOR;
+if (first_eps < 2.0 / (double) (n + 1))
+  first_eps = 2.0 / (double) (n + 1);
+start = fine_clock();
+init_heuristic();
+init_time = fine_clock() - start;
+return(first_eps * scale_factor);
+}
+
+/*
+Whether the first refine may keep v's initial matching arc.
+*/
+
+int	init_keep(v)
+
+lhs_ptr	v;
+
+{
+if (!match_holds(v))
+  return(FALSE);
+kept++;
+return(TRUE);
+}
+
+void	display_init()
+
+{
+(void) printf("|>   %s initializer: %.3f seconds, %u of %u matched\n",
+#if	defined(INIT_GREEDY)
+	      "greedy",
+#elif	defined(INIT_AUCTION)
+	      "auction",
+#else
+	      "dual ascent",
+#endif
+	      init_time, started, (unsigned) (tail_lhs_node - head_lhs_node));
+(void) printf("|>   first refine at epsilon %lg kept %u\n", first_eps, kept);
+}
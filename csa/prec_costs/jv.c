@@ -0,0 +1,493 @@
+#include	<stdio.h>
+#include	<stdlib.h>
+#include	"csa_types.h"
+#include	"csa_defs.h"
+
+/*
+Dense path: Jonker and Volgenant's shortest augmenting path algorithm
+(LAPJV) on a row-major matrix of costs, row i for lhs node i and
+column j for rhs node j, in place of cost scaling. It is taken for
+cost matrices read by parse_matrix() in parse.c, and for arc lists
+covering at least DENSE_THRESH of the lhs-rhs pairs, which are copied
+into a matrix, a missing arc costing JV_BIG; a matrix holds a cost in
+eight bytes, where an arc holds it and a head pointer in sixteen.
+
+With as many rows as columns, the matching starts as in Jonker and
+Volgenant: column reduction, reduction transfer and two rounds of
+augmenting row reduction. Then each free row augments along a
+shortest path in reduced costs c(i, j) - v(j), grown Dijkstra-fashion
+a column at a time. The column prices v are kept so that every row's
+matched column is its least, and end as the rhs prices.
+
+The work is in sweeps along a row of the matrix and the column
+arrays: column minima, the least reduced costs of a row, and the
+relaxation of the distances to every column by a newly reached row,
+which also finds the next nearest column. Each sweep goes through the
+columns JV_BLOCK at a time, looking only for the least value in the
+block, which the compiler vectorizes, and looks for the column with
+that value in the best block alone, while it is still in cache.
+Columns already reached are kept out of the search by a penalty of
+JV_BIG rather than by indirection, since their distances are no more
+than any the relaxation can give them, so the sweeps stay contiguous.
+*/
+
+#define	JV_BIG		1e30	/* cost of a missing arc */
+#define	JV_ARR_STEPS	4	/* row reductions per row, at most */
+
+/*
+The block kernels may treat every value as finite, so that minima
+vectorize.
+*/
+#define	JV_KERNEL	__attribute__ ((optimize ("finite-math-only", \
+						  "no-signed-zeros")))
+
+extern	unsigned	m;
+extern	lhs_ptr		head_lhs_node, tail_lhs_node;
+extern	rhs_ptr		head_rhs_node, tail_rhs_node;
+extern	double		fine_clock();
+
+/*
+The matrix, and whether it came from parse_matrix(), in which case
+each lhs node has a single arc, to be set to its matching arc.
+*/
+double		*jv_cost = NULL;
+int		jv_from_matrix = FALSE;
+int		dense_jv = FALSE;
+
+static	unsigned	rows, cols;
+static	double		density;
+static	double		*v, *key, *pen;
+static	int		*x, *y, *pred;
+static	unsigned	init_matched = 0;
+static	unsigned long	augmentations = 0, col_scans = 0;
+static	double		init_time = 0.0, aug_time = 0.0;
+
+static	void	infeasible()
+
+{
+void	exit();
+
+(void) printf("Infeasible problem\n");
+exit(9);
+}
+
+static	char	*jv_alloc(size)
+
+unsigned long	size;
+
+{
+char	*p;
+void	exit();
+
+if ((p = malloc(size ? size : 1)) == NULL)
+  {
+  (void) printf("Error: no memory for the dense solver\n");
+  exit(9);
+  }
+return(p);
+}
+
+/*
+key[k] = min(key[k], row[k] - v[k] + shift) for k in [lo, hi), with
+pred[k] = i where it drops; return the least key[k] + pen[k] there.
+*/
+
+JV_KERNEL
+static	double	relax_block(row, shift, i, lo, hi)
+
+double		*row, shift;
+int		i;
+unsigned	lo, hi;
+
+{
+unsigned	k;
+double		h, old, t, least = 4.0 * JV_BIG;
+
+for (k = lo; k < hi; k++)
+  {
+  h = row[k] - v[k] + shift;
+  old = key[k];
+  key[k] = h < old ? h : old;
+  pred[k] = h < old ? i : pred[k];
+  t = key[k] + pen[k];
+  least = t < least ? t : least;
+  }
+return(least);
+}
+
+/*
+Least row[k] - v[k] for k in [lo, hi).
+*/
+
+JV_KERNEL
+static	double	least_block(row, lo, hi)
+
+double		*row;
+unsigned	lo, hi;
+
+{
+unsigned	k;
+double		h, least = 4.0 * JV_BIG;
+
+for (k = lo; k < hi; k++)
+  {
+  h = row[k] - v[k];
+  least = h < least ? h : least;
+  }
+return(least);
+}
+
+/*
+The column in [lo, hi) of least reduced cost in row, the first if
+several tie, and that cost in *least; hi if the range is empty.
+*/
+
+static	unsigned	arg_least(row, lo, hi, least)
+
+double		*row, *least;
+unsigned	lo, hi;
+
+{
+unsigned	b, b_best = hi, k;
+double		t;
+
+*least = 4.0 * JV_BIG;
+for (b = lo; b < hi; b += JV_BLOCK)
+  if ((t = least_block(row, b, (hi - b > JV_BLOCK) ? b + JV_BLOCK : hi)) <
+      *least)
+    {
+    *least = t;
+    b_best = b;
+    }
+for (k = b_best; k < hi; k++)
+  if (row[k] - v[k] == *least)
+    break;
+return(k);
+}
+
+/*
+Relax the distances by row i, reached at a distance of shift more
+than its reduced costs, and return the nearest column not yet
+reached, with its distance in *least.
+*/
+
+static	unsigned	relax(row, shift, i, least)
+
+double	*row, shift, *least;
+int	i;
+
+{
+unsigned	b, b_best = 0, k;
+double		t;
+
+*least = 4.0 * JV_BIG;
+for (b = 0; b < cols; b += JV_BLOCK)
+  if ((t = relax_block(row, shift, i, b,
+		       (cols - b > JV_BLOCK) ? b + JV_BLOCK : cols)) < *least)
+    {
+    *least = t;
+    b_best = b;
+    }
+for (k = b_best; k < cols; k++)
+  if (key[k] + pen[k] == *least)
+    break;
+return(k);
+}
+
+/*
+Column reduction, reduction transfer and augmenting row reduction;
+return the number of free rows, listed in free_rows[].
+*/
+
+static	unsigned	jv_init(free_rows)
+
+int	*free_rows;
+
+{
+int		i, i0, j, j1, j2, *matches;
+unsigned	f, k, prev_f, round;
+unsigned long	steps = 0;
+double		*row, umin, usub, s1, s2;
+
+/*
+Column minima, a row at a time.
+*/
+matches = (int *) jv_alloc(rows * sizeof(int));
+for (j = 0; j < cols; j++)
+  {
+  key[j] = JV_BIG;
+  pred[j] = 0;
+  }
+for (i = 0; i < rows; i++)
+  {
+  matches[i] = 0;
+  (void) relax_block(jv_cost + (unsigned long) i * cols, 0.0, i, 0, cols);
+  }
+for (j = cols - 1; j >= 0; j--)
+  {
+  v[j] = key[j];
+  i = pred[j];
+  if (++matches[i] == 1)
+    {
+    x[i] = j;
+    y[j] = i;
+    }
+  else if (v[j] < v[x[i]])
+    {
+    j1 = x[i];
+    x[i] = j;
+    y[j] = i;
+    y[j1] = -1;
+    }
+  else
+    y[j] = -1;
+  }
+
+/*
+Reduction transfer.
+*/
+f = 0;
+for (i = 0; i < rows; i++)
+  if (matches[i] == 0)
+    free_rows[f++] = i;
+  else if ((matches[i] == 1) && (cols > 1))
+    {
+    row = jv_cost + (unsigned long) i * cols;
+    j1 = x[i];
+    s1 = least_block(row, 0, j1);
+    s2 = least_block(row, j1 + 1, cols);
+    v[j1] -= s1 < s2 ? s1 : s2;
+    }
+(void) free((char *) matches);
+
+/*
+Augmenting row reduction: a free row takes its least column, from
+its mate if need be, and lowers the column's price so that the
+second least ties; a row so displaced tries again at once if the
+price went down, and in the next round otherwise. Rows can push each
+other out many times over when costs are close, so after JV_ARR_STEPS
+reductions per row the rows left free are left to augmentation.
+*/
+for (round = 0; (round < 2) && (cols > 1); round++)
+  {
+  k = 0;
+  prev_f = f;
+  f = 0;
+  while (k < prev_f)
+    {
+    if (steps++ >= (unsigned long) JV_ARR_STEPS * rows)
+      {
+      while (k < prev_f)
+	free_rows[f++] = free_rows[k++];
+      round = 2;
+      break;
+      }
+    i = free_rows[k++];
+    row = jv_cost + (unsigned long) i * cols;
+    j1 = arg_least(row, 0, cols, &umin);
+    j = arg_least(row, 0, j1, &s1);
+    j2 = arg_least(row, j1 + 1, cols, &s2);
+    if (s1 <= s2)
+      {
+      j2 = j;
+      usub = s1;
+      }
+    else
+      usub = s2;
+    i0 = y[j1];
+    if (umin < usub)
+      v[j1] -= usub - umin;
+    else if (i0 >= 0)
+      {
+      j1 = j2;
+      i0 = y[j2];
+      }
+    x[i] = j1;
+    y[j1] = i;
+    if (i0 >= 0)
+      {
+      x[i0] = -1;
+      if (umin < usub)
+	free_rows[--k] = i0;
+      else
+	free_rows[f++] = i0;
+      }
+    }
+  }
+return(f);
+}
+
+/*
+Augment from free row f along a shortest path to a free column.
+*/
+
+static	void	augment(f, reached)
+
+int	f, *reached;
+
+{
+unsigned	r = 0, k, j;
+int		i, t;
+double		*row, least;
+
+for (k = 0; k < cols; k++)
+  key[k] = 4.0 * JV_BIG;
+row = jv_cost + (unsigned long) f * cols;
+j = relax(row, 0.0, f, &least);
+while ((i = y[j]) >= 0)
+  {
+  pen[j] = JV_BIG;
+  reached[r++] = j;
+  row = jv_cost + (unsigned long) i * cols;
+  j = relax(row, least - (row[j] - v[j]), i, &least);
+  }
+if (least >= JV_BIG)
+  infeasible();
+col_scans += r + 1;
+augmentations++;
+
+for (k = 0; k < r; k++)
+  {
+  v[reached[k]] += key[reached[k]] - least;
+  pen[reached[k]] = 0.0;
+  }
+do
+  {
+  i = pred[j];
+  y[j] = i;
+  t = x[i];
+  x[i] = j;
+  j = t;
+  }
+while (i != f);
+}
+
+/*
+Whether to solve the instance by the dense path: always for a cost
+matrix, otherwise when the arcs cover DENSE_THRESH of the pairs, in
+which case they are copied into a matrix. The largest cost sets the
+cost of missing arcs apart from any that matter.
+*/
+
+int	jv_choose(max_cost)
+
+double	max_cost;
+
+{
+lhs_ptr		v0;
+lr_aptr		a, a_stop;
+double		*cell;
+unsigned long	i;
+
+rows = tail_lhs_node - head_lhs_node;
+cols = tail_rhs_node - head_rhs_node;
+density = (rows && cols) ? (double) m / ((double) rows * (double) cols)
+			 : 0.0;
+if (jv_from_matrix)
+  return(dense_jv = TRUE);
+if ((density < DENSE_THRESH) || (max_cost * (rows + 1) >= JV_BIG / 4.0))
+  return(dense_jv = FALSE);
+
+jv_cost = (double *) jv_alloc((unsigned long) rows * cols * sizeof(double));
+for (i = 0; i < (unsigned long) rows * cols; i++)
+  jv_cost[i] = JV_BIG;
+for (v0 = head_lhs_node; v0 != tail_lhs_node; v0++)
+  {
+  a_stop = (v0 + 1)->priced_out;
+  for (a = v0->priced_out; a != a_stop; a++)
+    {
+    cell = jv_cost + (unsigned long) (v0 - head_lhs_node) * cols +
+	   (a->head - head_rhs_node);
+    if (a->c < *cell)
+      *cell = a->c;
+    }
+  }
+return(dense_jv = TRUE);
+}
+
+void	jv_solve()
+
+{
+int		*free_rows, *reached, j;
+unsigned	f, k;
+lhs_ptr		v0;
+rhs_ptr		w;
+lr_aptr		a, a_stop;
+double		start, c;
+
+v = (double *) jv_alloc(cols * sizeof(double));
+key = (double *) jv_alloc(cols * sizeof(double));
+pen = (double *) jv_alloc(cols * sizeof(double));
+x = (int *) jv_alloc(rows * sizeof(int));
+y = (int *) jv_alloc(cols * sizeof(int));
+pred = (int *) jv_alloc(cols * sizeof(int));
+free_rows = (int *) jv_alloc(rows * sizeof(int));
+reached = (int *) jv_alloc(cols * sizeof(int));
+for (j = 0; j < cols; j++)
+  {
+  v[j] = pen[j] = 0.0;
+  y[j] = -1;
+  }
+
+start = fine_clock();
+if (rows == cols)
+  f = jv_init(free_rows);
+else
+  for (f = 0; f < rows; f++)
+    {
+    x[f] = -1;
+    free_rows[f] = f;
+    }
+init_matched = rows - f;
+init_time = fine_clock() - start;
+
+start = fine_clock();
+while (f > 0)
+  augment(free_rows[--f], reached);
+aug_time = fine_clock() - start;
+
+for (w = head_rhs_node, j = 0; w != tail_rhs_node; w++, j++)
+  {
+  w->p = v[j];
+  w->matched = NULL;
+  }
+for (v0 = head_lhs_node, k = 0; v0 != tail_lhs_node; v0++, k++)
+  {
+  w = head_rhs_node + x[k];
+  c = jv_cost[(unsigned long) k * cols + x[k]];
+  if (c >= JV_BIG)
+    infeasible();
+  if (jv_from_matrix)
+    {
+    a = v0->first;
+    a->head = w;
+    a->c = c;
+    }
+  else
+    {
+    a_stop = (v0 + 1)->priced_out;
+    for (a = v0->priced_out; (a != a_stop) && ((a->head != w) || (a->c != c));
+	 a++)
+      ;
+    }
+  v0->matched = a;
+  w->matched = v0;
+  }
+}
+
+void	display_jv()
+
+{
+if (dense_jv)
+  {
+  (void) printf("|>   dense JV on a %u x %u matrix, density %lg\n",
+		rows, cols, density);
+  (void) printf("|>   %u of %u matched by initialization in %.3f seconds\n",
+		init_matched, rows, init_time);
+  (void) printf("|>   %lu augmentations, %lu columns reached, %.3f seconds\n",
+		augmentations, col_scans, aug_time);
+  }
+else
+  (void) printf("|>   density %lg below %lg; cost scaling used\n",
+		density, (double) DENSE_THRESH);
+}
@@ -13,6 +13,80 @@ extern	double	epsilon;
 
 extern	unsigned	p_updates, u_scans;
 extern	unsigned	p_update_time, myclock();
+#ifdef	PAR_P_UPDATE
+extern	double	p_update_secs, fine_clock();
+#endif
+
+#ifdef	PAR_P_UPDATE
+/*
+In the PAR_P_UPDATE case the nodes of each bucket level are scanned
+concurrently, delta-stepping fashion: bucket[level] is detached into a
+frontier array whose runs threads claim with par_claim(). Key and
+delta_reqd decreases are made with compare-and-swap, and a thread
+notes each node whose key it lowered in a list of its own. When the
+level's frontier is done, the lists are merged into the buckets
+(nodes lowered to the current level form the next frontier), using
+the listed field to find the bucket a node is linked into. Scanning a
+whole frontier at once can't change the prices computed: when balance
+reaches zero all the excesses are claimed at the current level, which
+is also the price change applied to nodes left unscanned.
+*/
+#include	<stdlib.h>
+
+extern	unsigned	num_threads;
+extern	void		par_run();
+extern	int		par_claim();
+extern	lhs_ptr		par_claim_lhs();
+
+typedef	struct	moved_list	{
+				rhs_ptr		*w;
+				unsigned	n, size;
+				unsigned	found;
+				}	moved_list;
+
+static	moved_list	*moved = NULL;
+static	rhs_ptr		*frontier = NULL;	/* nodes of the current level */
+static	unsigned	frontier_n;
+static	PAR_LOCAL moved_list	*my_moved;
+
+static	void	note_moved(u)
+
+rhs_ptr	u;
+
+{
+moved_list	*l = my_moved;
+void	exit();
+
+if (l->n == l->size)
+  {
+  l->size = 2 * l->size + 16;
+  l->w = (rhs_ptr *) realloc((char *) l->w, l->size * sizeof(rhs_ptr));
+  if (l->w == NULL)
+    {
+    (void) printf("Can't obtain enough memory to solve this problem.\n");
+    exit(9);
+    }
+  }
+l->w[l->n++] = u;
+}
+
+/*
+Lower *k to new if that decreases it, returning TRUE if so.
+*/
+
+static	int	lower_key(k, new)
+
+long	*k, new;
+
+{
+long	old;
+
+while ((old = *k) > new)
+  if (__sync_bool_compare_and_swap(k, old, new))
+    return(TRUE);
+return(FALSE);
+}
+#endif	/* PAR_P_UPDATE */
 
 /*
 Doing a u_scan on w updates the current estimate of required price
@@ -34,7 +108,9 @@ register	double	p;
 double	u_to_w_cost;
 unsigned	excess_found = 0;
 
+#ifndef	PAR_P_UPDATE
 u_scans++;
+#endif
 b_stop = (w+1)->priced_out;
 p = w->p;
 wk = w->key;
@@ -62,6 +138,10 @@ for (b = w->back_arcs; b != b_stop; b++)
 	    uk = wk + 1 + (long) (u_to_w_cost / epsilon);
 	  else
 	    uk = u->key;
+#ifdef	PAR_P_UPDATE
+	if (lower_key(&u->key, uk))
+	  note_moved(u);
+#else
 	if (u->key > uk)
 	  {
 	  if (u->key != num_buckets)
@@ -69,6 +149,7 @@ for (b = w->back_arcs; b != b_stop; b++)
 	  u->key = uk;
 	  insert_list(u, &bucket[uk]);
 	  }
+#endif
 	}
       }
     }
@@ -85,6 +166,10 @@ for (b = w->back_arcs; b != b_stop; b++)
     if ((u_to_w_cost = b->c - p) < epsilon * ((v = b->tail)->delta_reqd - wk))
       {
       uk = wk + (long) ceil(u_to_w_cost / epsilon);
+#ifdef	PAR_P_UPDATE
+      if (lower_key(&v->delta_reqd, uk) && (uk == 0))
+	excess_found++;
+#else
       if (uk < v->delta_reqd)
 	{
 	if (uk == 0)
@@ -97,6 +182,7 @@ for (b = w->back_arcs; b != b_stop; b++)
 	  }
 	v->delta_reqd = uk;
 	}
+#endif
       }
 
 w->p -= epsilon * w->key;
@@ -104,79 +190,185 @@ w->key = -1;
 return(excess_found);
 }
 
-void	p_update()
+/*
+Offset the stored costs of the back arcs of lhs node v's arcs so the
+back arcs of interest to u_scan() have zero stored cost, and set up
+v's delta_reqd if v is unmatched.
+*/
+
+static	void	offset_node(v)
 
-{
-rhs_ptr	w;
 lhs_ptr	v;
+
+{
 double	delta_c, this_cost;
-long	balance, level;
 lr_aptr	a, a_stop;
 
-p_update_time -= myclock();
-p_updates++;
-
-#ifdef	DEBUG
-(void) printf("Doing p_update(): epsilon = %lg, total_e = %lu\n",
-	      epsilon, total_e);
-#endif
-
-for (v = head_lhs_node; v != tail_lhs_node; v++)
-  {
-  a_stop = (v+1)->priced_out;
+a_stop = (v+1)->priced_out;
 #ifdef	P_U_ZERO_BACK_MCH_ARCS
-  if (v->matched)
+if (v->matched)
+  {
+  if (v->matched->head->node_info.priced_in)
     {
-    if (v->matched->head->node_info.priced_in)
-      {
-      /*
-      Offset back arc costs so back matching arc has zero stored cost
-      */
-      delta_c = v->matched->rev->c;
+    /*
+    Offset back arc costs so back matching arc has zero stored cost
+    */
+    delta_c = v->matched->rev->c;
 #ifdef	STRONG_PO
-      /*
-      In the case of strong price-outs, we could price in a back arc
-      later that's priced out now. So offset the costs of all the
-      incident back arcs.
-      */
-      a = v->priced_out;
+    /*
+    In the case of strong price-outs, we could price in a back arc
+    later that's priced out now. So offset the costs of all the
+    incident back arcs.
+    */
+    a = v->priced_out;
 #else
-      a = v->first;
+    a = v->first;
 #endif
-      for (; a != a_stop; a++)
-	a->rev->c -= delta_c;
-      }
+    for (; a != a_stop; a++)
+      a->rev->c -= delta_c;
     }
-  else
+  }
+else
 #else
-  if (!v->matched)
+if (!v->matched)
 #endif
-    {
+  {
 #ifdef	DEBUG
-    (void) printf("excess at node %ld\n", v - head_lhs_node + 1);
+  (void) printf("excess at node %ld\n", v - head_lhs_node + 1);
 #endif
-    v->delta_reqd = num_buckets;
-    a = v->first;
+  v->delta_reqd = num_buckets;
+  a = v->first;
 #ifdef	NO_FEAS_PROMISE
-    if (a == a_stop)
-      {
-      (void) printf("Infeasible problem\n");
-      exit(9);
-      }
+  if (a == a_stop)
+    {
+    (void) printf("Infeasible problem\n");
+    exit(9);
+    }
 #endif
-    delta_c = a->rev->c - a->head->p;
-    for (a++; a != a_stop; a++)
-      if ((this_cost = a->rev->c - a->head->p) < delta_c)
-	delta_c = this_cost;
+  delta_c = a->rev->c - a->head->p;
+  for (a++; a != a_stop; a++)
+    if ((this_cost = a->rev->c - a->head->p) < delta_c)
+      delta_c = this_cost;
 #ifdef	STRONG_PO
-    a_stop = v->priced_out - 1;
+  a_stop = v->priced_out - 1;
 #else
-    a_stop = v->first - 1;
+  a_stop = v->first - 1;
 #endif
-    for (a--; a != a_stop; a--)
-      a->rev->c -= delta_c;
+  for (a--; a != a_stop; a--)
+    a->rev->c -= delta_c;
+  }
+}
+
+#ifdef	PAR_P_UPDATE
+static	void	offset_thread(id)
+
+unsigned	id;
+
+{
+lhs_ptr	v, v_stop;
+
+while ((v = par_claim_lhs(&v_stop)) != NULL)
+  for (; v != v_stop; v++)
+    offset_node(v);
+}
+
+static	void	scan_thread(id)
+
+unsigned	id;
+
+{
+unsigned	i, stop;
+
+my_moved = &moved[id];
+my_moved->n = my_moved->found = 0;
+while (par_claim(frontier_n, &i, &stop))
+  for (; i != stop; i++)
+    my_moved->found += u_scan(frontier[i]);
+}
+
+/*
+Scan the frontier, in parallel if it's big enough to be worth it, and
+put the nodes whose keys were lowered in their new buckets. Return the
+number of excesses claimed.
+*/
+
+static	long	scan_frontier()
+
+{
+moved_list	*l;
+rhs_ptr		u;
+long		found = 0;
+unsigned	i, j, t = num_threads;
+
+u_scans += frontier_n;
+if (frontier_n < PAR_CHUNK)
+  {
+  t = 1;
+  my_moved = &moved[0];
+  my_moved->n = my_moved->found = 0;
+  for (i = 0; i < frontier_n; i++)
+    my_moved->found += u_scan(frontier[i]);
+  }
+else
+  par_run(scan_thread);
+for (l = moved; l != moved + t; l++)
+  {
+  found += l->found;
+  for (j = 0; j < l->n; j++)
+    {
+    u = l->w[j];
+    if (u->listed != u->key)
+      {
+      if (u->listed != num_buckets)
+	delete_list(u, &bucket[u->listed]);
+      u->listed = u->key;
+      insert_list(u, &bucket[u->key]);
+      }
+    }
+  }
+return(found);
+}
+#endif	/* PAR_P_UPDATE */
+
+void	p_update()
+
+{
+rhs_ptr	w;
+lhs_ptr	v;
+double	delta_c;
+long	balance, level;
+#ifdef	PAR_P_UPDATE
+void	exit();
+#endif
+
+p_update_time -= myclock();
+#ifdef	PAR_P_UPDATE
+p_update_secs -= fine_clock();
+#endif
+p_updates++;
+
+#ifdef	DEBUG
+(void) printf("Doing p_update(): epsilon = %lg, total_e = %lu\n",
+	      epsilon, total_e);
+#endif
+
+#ifdef	PAR_P_UPDATE
+if (moved == NULL)
+  {
+  moved = (moved_list *) calloc(num_threads, sizeof(moved_list));
+  frontier = (rhs_ptr *) malloc((tail_rhs_node - head_rhs_node) *
+				 sizeof(rhs_ptr));
+  if ((moved == NULL) || (frontier == NULL))
+    {
+    (void) printf("Can't obtain enough memory to solve this problem.\n");
+    exit(9);
     }
   }
+par_run(offset_thread);
+#else
+for (v = head_lhs_node; v != tail_lhs_node; v++)
+  offset_node(v);
+#endif
 
 for (w = head_rhs_node; w != tail_rhs_node; w++)
   if (w->matched)
@@ -186,8 +378,12 @@ for (w = head_rhs_node; w != tail_rhs_node; w++)
     w->key = 0;
     insert_list(w, &bucket[0]);
     }
+#ifdef	PAR_P_UPDATE
+for (w = head_rhs_node; w != tail_rhs_node; w++)
+  w->listed = w->key;
+#endif
 
-balance = -total_e;
+balance = -(long) total_e;
 level = 0;
 
 while ((balance < 0) && (level < num_buckets))
@@ -195,8 +391,15 @@ while ((balance < 0) && (level < num_buckets))
     level++;
   else
     {
+#ifdef	PAR_P_UPDATE
+    frontier_n = 0;
+    while (bucket[level] != tail_rhs_node)
+      frontier[frontier_n++] = deq_list(&bucket[level]);
+    balance += scan_frontier();
+#else
     w = deq_list(&bucket[level]);
     balance += u_scan(w);
+#endif
     }
 
 /*
@@ -224,5 +427,8 @@ for (w = head_rhs_node; w != tail_rhs_node; w++)
     w->p -= delta_c;
   }
 
+#ifdef	PAR_P_UPDATE
+p_update_secs += fine_clock();
+#endif
 p_update_time += myclock();
 }
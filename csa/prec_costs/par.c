@@ -0,0 +1 @@
+../par.c
\ No newline at end of file
@@ -0,0 +1,377 @@
+#include	<stdio.h>
+#include	<stdlib.h>
+#include	<string.h>
+#include	<limits.h>
+#include	<signal.h>
+#include	<fcntl.h>
+#include	<unistd.h>
+#include	<sys/types.h>
+#include	<sys/stat.h>
+#include	<sys/wait.h>
+#include	<sys/time.h>
+
+/*
+Portfolio driver: race several solver configurations on the same
+instance and keep the result of whichever finishes first.
+
+Usage: csa_portfolio [config ...] < instance
+where each config is a variant name optionally followed by its command
+line parameters, separated by commas, e.g. "csa_s_spo_qm,10,2.5". With
+no configs, DEFAULT_CONFIGS are raced.
+
+The variants are separate executables, and each keeps all its state in
+globals, so the configurations are run as separate processes rather
+than threads. The instance is read once into a scratch file that every
+configuration reads; each configuration runs in its own scratch
+directory so output files don't collide. When the first configuration
+exits successfully, the others are killed, the winner's output is
+copied to our standard output (and its output file, if any, to the
+current directory), and a line naming the winner, the features of
+the instance that csa_auto selects by (see auto_tune.c) and the wall
+time is appended to PORTFOLIO_LOG. "script/train-tune --log" turns
+such a log into decision-table rows for csa_auto.
+*/
+
+#define	DEFAULT_CONFIGS	{"csa_s_qm", "csa_s_spo_qm", "csa_s_pu_qm", NULL}
+#define	PORTFOLIO_LOG	"portfolio.log"
+#define	MAX_CONFIGS	16
+#define	MAX_ARGS	8
+#define	PATH_LEN	1024
+#define	NAME_ROOM	32	/* room for "/<config>/output.flow" past PATH_LEN */
+#define	SMALL_DEGREE	4	/* as in auto_tune.c */
+#define	NUM_FEATURES	5
+
+typedef	struct	config	{
+			char	*argv[MAX_ARGS + 1];
+			char	path[PATH_MAX];
+			char	dir[PATH_LEN + 4];
+			pid_t	pid;
+			}	config;
+
+static	char	scratch[PATH_LEN];
+static	config	cfg[MAX_CONFIGS];
+static	int	num_cfgs = 0;
+
+static	double	wall_clock()
+
+{
+struct	timeval	tv;
+
+(void) gettimeofday(&tv, NULL);
+return((double) tv.tv_sec + (double) tv.tv_usec / 1e6);
+}
+
+static	void	copy_file(from, to)
+
+int	from, to;
+
+{
+char	buf[BUFSIZ];
+ssize_t	len;
+
+while ((len = read(from, buf, sizeof(buf))) > 0)
+  if (write(to, buf, (size_t) len) != len)
+    {
+    perror("csa_portfolio: write");
+    exit(1);
+    }
+}
+
+static	void	copy_named(from, to)
+
+char	*from, *to;
+
+{
+int	in, out;
+
+if ((in = open(from, O_RDONLY)) < 0)
+  return;
+if ((out = open(to, O_WRONLY | O_CREAT | O_TRUNC, 0644)) >= 0)
+  {
+  copy_file(in, out);
+  (void) close(out);
+  }
+(void) close(in);
+}
+
+static	void	kill_others(winner)
+
+config	*winner;
+
+{
+int	i;
+
+for (i = 0; i < num_cfgs; i++)
+  if ((&cfg[i] != winner) && (cfg[i].pid > 0))
+    {
+    (void) kill(cfg[i].pid, SIGKILL);
+    (void) waitpid(cfg[i].pid, NULL, 0);
+    cfg[i].pid = 0;
+    }
+}
+
+static	void	clean_up()
+
+{
+char	buf[PATH_LEN + NAME_ROOM];
+int	i;
+
+for (i = 0; i < num_cfgs; i++)
+  {
+  (void) snprintf(buf, sizeof(buf), "%s/stdout", cfg[i].dir);
+  (void) unlink(buf);
+  (void) snprintf(buf, sizeof(buf), "%s/output.flow", cfg[i].dir);
+  (void) unlink(buf);
+  (void) rmdir(cfg[i].dir);
+  }
+(void) snprintf(buf, sizeof(buf), "%s/input", scratch);
+(void) unlink(buf);
+(void) rmdir(scratch);
+}
+
+static	void	interrupted(sig)
+
+int	sig;
+
+{
+kill_others(NULL);
+clean_up();
+_exit(1);
+}
+
+/*
+Read the instance features csa_auto looks up in its decision table
+from the scratch copy of the input: average lhs degree, fraction of
+lhs nodes with at most SMALL_DEGREE arcs, maximum absolute cost,
+number of nodes, and lhs/rhs balance. Also count the arcs.
+*/
+
+static	void	inst_features(input, feat, arcs)
+
+char		*input;
+double		feat[];
+unsigned long	*arcs;
+
+{
+FILE		*f;
+char		line[BUFSIZ];
+unsigned long	nodes = 0, lhs = 0, used = 0, small = 0, tail, head, i;
+unsigned	*degree = NULL;
+double		cost, max_cost = 0.0;
+
+for (i = 0; i < NUM_FEATURES; i++)
+  feat[i] = 0.0;
+*arcs = 0;
+if ((f = fopen(input, "r")) == NULL)
+  return;
+while (fgets(line, sizeof(line), f) != NULL)
+  if ((line[0] == 'p') && (degree == NULL) &&
+      (sscanf(line, "p %*s %lu", &nodes) == 1))
+    degree = (unsigned *) calloc(nodes + 1, sizeof(unsigned));
+  else if (line[0] == 'n')
+    lhs++;
+  else if ((line[0] == 'a') &&
+	   (sscanf(line, "a %lu %lu %lg", &tail, &head, &cost) == 3))
+    {
+    (*arcs)++;
+    if (degree && (tail <= nodes))
+      degree[tail]++;
+    if (cost < 0.0)
+      cost = -cost;
+    if (cost > max_cost)
+      max_cost = cost;
+    }
+(void) fclose(f);
+if ((degree == NULL) || (lhs == 0) || (lhs >= nodes))
+  {
+  free((char *) degree);
+  return;
+  }
+/*
+Arcs run from lhs nodes, so an lhs node without arcs is one not seen.
+*/
+for (i = 1; i <= nodes; i++)
+  if (degree[i] > 0)
+    {
+    used++;
+    if (degree[i] <= SMALL_DEGREE)
+      small++;
+    }
+free((char *) degree);
+feat[0] = (double) *arcs / (double) lhs;
+feat[1] = (double) (small + lhs - used) / (double) lhs;
+feat[2] = max_cost;
+feat[3] = (double) nodes;
+feat[4] = (double) lhs / (double) (nodes - lhs);
+}
+
+/*
+Split a config string into its variant name and parameters, and find
+the variant's executable in the same directory as ours (see
+sibling.c). The path is absolute, as the children run in their
+scratch directories.
+*/
+
+static	void	parse_config(c, spec, argv0)
+
+config	*c;
+char	*spec, *argv0;
+
+{
+int	i = 0;
+int	sibling_path();
+
+c->argv[i++] = strtok(spec, ",");
+while ((i < MAX_ARGS) && (c->argv[i] = strtok(NULL, ",")))
+  i++;
+c->argv[i] = NULL;
+if (!sibling_path(c->argv[0], argv0, c->path))
+  {
+  (void) fprintf(stderr, "csa_portfolio: can't execute %s\n", c->argv[0]);
+  exit(1);
+  }
+}
+
+static	void	launch(c, input)
+
+config	*c;
+char	*input;
+
+{
+char	out[PATH_LEN + NAME_ROOM];
+int	fd;
+
+if ((c->pid = fork()) < 0)
+  {
+  perror("csa_portfolio: fork");
+  interrupted(0);
+  }
+if (c->pid == 0)
+  {
+  (void) snprintf(out, sizeof(out), "%s/stdout", c->dir);
+  if (((fd = open(input, O_RDONLY)) < 0) || (dup2(fd, 0) < 0) ||
+      ((fd = open(out, O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0) ||
+      (dup2(fd, 1) < 0) || chdir(c->dir))
+    _exit(127);
+  (void) execv(c->path, c->argv);
+  (void) fprintf(stderr, "csa_portfolio: can't execute %s\n", c->path);
+  _exit(127);
+  }
+}
+
+int	main(argc, argv)
+
+int	argc;
+char	*argv[];
+
+{
+static	char	*defaults[] = DEFAULT_CONFIGS;
+char	input[PATH_LEN + NAME_ROOM], buf[PATH_LEN + NAME_ROOM], *tmp;
+unsigned long	arcs;
+config	*winner = NULL;
+double	start, feat[NUM_FEATURES];
+FILE	*log;
+pid_t	pid;
+int	i, status, fd;
+
+if (argc - 1 > MAX_CONFIGS)
+  {
+  (void) fprintf(stderr, "csa_portfolio: at most %d configs\n", MAX_CONFIGS);
+  exit(1);
+  }
+if (argc > 1)
+  for (i = 1; i < argc; i++)
+    parse_config(&cfg[num_cfgs++], argv[i], argv[0]);
+else
+  for (i = 0; defaults[i]; i++)
+    parse_config(&cfg[num_cfgs++], strdup(defaults[i]), argv[0]);
+
+if ((tmp = getenv("TMPDIR")) == NULL)
+  tmp = "/tmp";
+if (strlen(tmp) + sizeof("/csa_portfolio.XXXXXX") > PATH_LEN)
+  {
+  (void) fprintf(stderr, "csa_portfolio: TMPDIR name too long\n");
+  exit(1);
+  }
+(void) snprintf(scratch, sizeof(scratch), "%s/csa_portfolio.XXXXXX", tmp);
+if (mkdtemp(scratch) == NULL)
+  {
+  perror("csa_portfolio: mkdtemp");
+  exit(1);
+  }
+(void) signal(SIGINT, interrupted);
+(void) signal(SIGTERM, interrupted);
+
+(void) snprintf(input, sizeof(input), "%s/input", scratch);
+if ((fd = open(input, O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0)
+  {
+  perror("csa_portfolio: input");
+  interrupted(0);
+  }
+copy_file(0, fd);
+(void) close(fd);
+
+start = wall_clock();
+for (i = 0; i < num_cfgs; i++)
+  {
+  (void) snprintf(cfg[i].dir, sizeof(cfg[i].dir), "%s/%d", scratch, i);
+  if (mkdir(cfg[i].dir, 0755))
+    {
+    perror("csa_portfolio: mkdir");
+    interrupted(0);
+    }
+  launch(&cfg[i], input);
+  }
+
+/*
+Wait for the first configuration to finish successfully. A
+configuration that fails doesn't end the race unless all of them do.
+*/
+while (!winner && ((pid = wait(&status)) > 0))
+  for (i = 0; i < num_cfgs; i++)
+    if (cfg[i].pid == pid)
+      {
+      cfg[i].pid = 0;
+      if (WIFEXITED(status) && (WEXITSTATUS(status) == 0))
+	winner = &cfg[i];
+      break;
+      }
+kill_others(winner);
+
+if (winner == NULL)
+  {
+  (void) fprintf(stderr, "csa_portfolio: every configuration failed\n");
+  clean_up();
+  exit(1);
+  }
+
+(void) snprintf(buf, sizeof(buf), "%s/stdout", winner->dir);
+if ((fd = open(buf, O_RDONLY)) >= 0)
+  {
+  copy_file(fd, 1);
+  (void) close(fd);
+  }
+(void) snprintf(buf, sizeof(buf), "%s/output.flow", winner->dir);
+copy_named(buf, "output.flow");
+
+(void) printf("|>  portfolio winner: %s", winner->argv[0]);
+for (i = 1; winner->argv[i]; i++)
+  (void) printf(" %s", winner->argv[i]);
+(void) printf(" (%d configs, %.3f seconds wall)\n", num_cfgs,
+	      wall_clock() - start);
+
+if ((log = fopen(PORTFOLIO_LOG, "a")))
+  {
+  inst_features(input, feat, &arcs);
+  for (i = 0; winner->argv[i]; i++)
+    (void) fprintf(log, "%s%s", i ? "," : "", winner->argv[i]);
+  (void) fprintf(log,
+		 " deg %lg small %lg cost %.0f n %.0f bal %lg m %lu time %.3f\n",
+		 feat[0], feat[1], feat[2], feat[3], feat[4], arcs,
+		 wall_clock() - start);
+  (void) fclose(log);
+  }
+
+clean_up();
+return(0);
+}
@@ -0,0 +1,509 @@
+#include	<stdio.h>
+#include	<stdlib.h>
+#include	"csa_types.h"
+#include	"csa_defs.h"
+
+/*
+Rectangular and imperfect assignment, without padding the instance
+out to a square one with dummy nodes. In the RECT_ASSIGN case every
+lhs node must be matched, parse() having made the lhs the smaller
+side, and the rhs nodes left over are free. In the IMPERFECT case
+(which implies RECT_ASSIGN) any node may be left unmatched, and we
+find the matching of greatest total weight, or least total cost in
+the MIN_COST case. Each lhs node then has a null node of its own,
+joined to it by an implicit arc of cost zero and priced by the node's
+null_p field; double_push() treats it like the head of any other arc,
+and an lhs node matched to it counts as unmatched. Once the active set
+is empty, an lhs node with no matching arc is matched to its null
+node, and the null nodes of the others are free.
+
+Epsilon-optimality of the arcs is not enough for these problems: no
+free node may be priced below a matched one, by more than epsilon in
+the course of scaling and by any amount at the end. Think of the free
+nodes as matched to a sink whose price lambda separates the two sets.
+A refine does not keep this so, since a node matched in an earlier
+refine can end up free with its low price, and lowering every matched
+node to the price of such a node would undo the work of the earlier
+refines. Instead, once the active set is empty, rect_settle() raises
+each free node priced below lambda, the highest price of a matched
+node, as in the reverse auction for asymmetric problems: the node
+offers to each lhs node adjacent to it the amount by which its price
+would have to rise for the lhs node to prefer it to its own match,
+and takes the lowest bidder at the second-lowest offer plus epsilon,
+but no higher than lambda. If even lambda doesn't win it anyone, it
+stays free at lambda. The rhs node the winner leaves may become a free
+node below lambda in turn. No lhs node is ever unmatched, every lhs
+node adjacent to a raised node still has an epsilon-optimal matching
+arc, and prices only rise toward lambda, so the pass ends, leaving
+the refine's matching epsilon-optimal for the problem with the sink.
+This needs the lhs nodes adjacent to each rhs node, which are listed
+once, the first time through; a raised price can move an arc into an
+lhs node's best list, so in the QUICK_MIN case the lists of the nodes
+adjacent to a raised node are built again.
+
+In the CAPACITY case (see cap.c) the slots of an rhs node w rise
+together. An lhs node matched to one slot of w must be priced within
+epsilon of w's best slot, so a free slot raised alone would only take
+the lhs nodes of w's other slots from them one by one, rising about
+epsilon at a time. Instead a free slot of w below floor bids among the
+lhs nodes not matched to w, and every slot of w priced below the price
+it bids is raised to it, which leaves the lhs nodes matched to w better
+off. Then another free slot of w below floor, if any, bids.
+*/
+
+#define	NO_BID	1e300	/* offer of a node with no second bidder */
+#define	NO_OFFER	((unsigned) -1)	/* best of a node with no bidder */
+
+extern	lhs_ptr		head_lhs_node, tail_lhs_node;
+extern	rhs_ptr		head_rhs_node, tail_rhs_node;
+extern	lr_aptr		head_lr_arc;
+extern	double		epsilon, min_epsilon;
+extern	int		in_swap;
+#ifdef	QUICK_MIN
+extern	void		best_build();
+#endif
+#ifdef	CAPACITY
+extern	void		cap_raise();
+#endif
+
+/*
+The arcs into rhs node j are rev_arc[rev_first[j]], ...,
+rev_arc[rev_first[j + 1] - 1], and rev_tail[] has their tails.
+*/
+static	unsigned	*rev_first = NULL;
+static	lr_aptr		*rev_arc;
+static	lhs_ptr		*rev_tail;
+/*
+Free nodes waiting to bid: rhs node j as j, and the null node of lhs
+node i as -(i + 1).
+*/
+static	long		*bidders;
+static	long		bidders_n;
+#ifdef	CAPACITY
+/*
+whether rhs node j is among the bidders already.
+*/
+static	char		*queued;
+#endif
+#ifdef	QUICK_MIN
+static	char		*stale;
+static	lhs_ptr		*stale_list;
+static	unsigned	stale_n = 0;
+#endif
+static	unsigned	settles = 0, bids = 0, raises = 0;
+
+static	void	rect_init()
+
+{
+unsigned	lhs_n = tail_lhs_node - head_lhs_node,
+		rhs_n = tail_rhs_node - head_rhs_node, j, k;
+lhs_ptr	v;
+lr_aptr	a, a_stop;
+void	exit();
+
+k = tail_lhs_node->priced_out - head_lr_arc;
+rev_first = (unsigned *) calloc(rhs_n + 1, sizeof(unsigned));
+rev_arc = (lr_aptr *) malloc((k ? k : 1) * sizeof(lr_aptr));
+rev_tail = (lhs_ptr *) malloc((k ? k : 1) * sizeof(lhs_ptr));
+bidders = (long *) malloc((rhs_n + lhs_n) * sizeof(long));
+#ifdef	CAPACITY
+if ((queued = (char *) calloc(rhs_n ? rhs_n : 1, 1)) == NULL)
+  bidders = NULL;
+#endif
+#ifdef	QUICK_MIN
+stale = (char *) calloc(lhs_n ? lhs_n : 1, 1);
+stale_list = (lhs_ptr *) malloc((lhs_n ? lhs_n : 1) * sizeof(lhs_ptr));
+if ((stale == NULL) || (stale_list == NULL))
+  rev_first = NULL;
+#endif
+if ((rev_first == NULL) || (rev_arc == NULL) || (rev_tail == NULL) ||
+    (bidders == NULL))
+  {
+  (void) printf("Error: no memory for the reverse arcs\n");
+  exit(9);
+  }
+for (a = head_lr_arc; a != tail_lhs_node->priced_out; a++)
+  rev_first[a->head - head_rhs_node + 1]++;
+for (j = 0; j < rhs_n; j++)
+  rev_first[j + 1] += rev_first[j];
+for (v = head_lhs_node; v != tail_lhs_node; v++)
+  {
+  a_stop = (v + 1)->priced_out;
+  for (a = v->priced_out; a != a_stop; a++)
+    {
+    j = a->head - head_rhs_node;
+    rev_arc[rev_first[j]] = a;
+    rev_tail[rev_first[j]++] = v;
+    }
+  }
+for (j = rhs_n; j > 0; j--)
+  rev_first[j] = rev_first[j - 1];
+rev_first[0] = 0;
+}
+
+/*
+Partial reduced cost of v's match.
+*/
+
+static	double	match_pref(v)
+
+lhs_ptr	v;
+
+{
+#ifdef	IMPERFECT
+if (v->matched == NULL)
+  return(-v->null_p);
+#endif
+#ifdef	CAPACITY
+return(v->matched->c - v->matched->head->slots[v->slot].p);
+#else
+return(v->matched->c - v->matched->head->p);
+#endif
+}
+
+#ifdef	QUICK_MIN
+static	void	mark_stale(v)
+
+lhs_ptr	v;
+
+{
+if (!stale[v - head_lhs_node] && !v->node_info.few_arcs)
+  {
+  stale[v - head_lhs_node] = TRUE;
+  stale_list[stale_n++] = v;
+  }
+}
+#endif
+
+/*
+Let v leave its match, freeing the node it leaves, which must bid if
+its price is below floor.
+*/
+
+static	void	leave(v, floor)
+
+lhs_ptr	v;
+double	floor;
+
+{
+rhs_ptr	x;
+
+#ifdef	IMPERFECT
+if (v->matched == NULL)
+  {
+  if (v->null_p < floor)
+    bidders[bidders_n++] = -(long) (v - head_lhs_node) - 1;
+  return;
+  }
+#endif
+x = v->matched->head;
+#ifdef	CAPACITY
+x->slots[v->slot].mate = NULL;
+if (v->slot == 0)
+  x->matched = NULL;
+if ((x->slots[v->slot].p < floor) && !queued[x - head_rhs_node])
+  {
+  queued[x - head_rhs_node] = TRUE;
+  bidders[bidders_n++] = x - head_rhs_node;
+  }
+#else
+x->matched = NULL;
+if (x->p < floor)
+  bidders[bidders_n++] = x - head_rhs_node;
+#endif
+}
+
+/*
+Find the offers of a free node of w priced at p: the lowest, d1, made
+through the arc in rev_arc[*best], and the second-lowest, d2. In the
+CAPACITY case the lhs nodes matched to w make no offers.
+*/
+
+static	void	offers(w, p, best, d1, d2)
+
+rhs_ptr		w;
+double		p;
+unsigned	*best;
+double		*d1, *d2;
+
+{
+unsigned	j = w - head_rhs_node, k;
+double		d;
+
+*d1 = *d2 = NO_BID;
+*best = NO_OFFER;
+for (k = rev_first[j]; k != rev_first[j + 1]; k++)
+  {
+#ifdef	CAPACITY
+  if (rev_tail[k]->matched && (rev_tail[k]->matched->head == w))
+    continue;
+#endif
+  d = rev_arc[k]->c - p - match_pref(rev_tail[k]);
+  if (d < *d1)
+    {
+    *d2 = *d1;
+    *d1 = d;
+    *best = k;
+    }
+  else if (d < *d2)
+    *d2 = d;
+  }
+}
+
+/*
+Raise the price *p of a free node offering d1 and d2 as far as it
+must go to win its lowest bidder, but no further than lambda; return
+whether it wins.
+*/
+
+static	int	bid(p, d1, d2, lambda)
+
+double	*p, d1, d2, lambda;
+
+{
+double	raise = lambda - *p;
+
+bids++;
+if (d2 + epsilon < raise)
+  raise = d2 + epsilon;
+if (raise < d1)
+  {
+  settles++;
+  *p = lambda;
+  return(FALSE);
+  }
+raises++;
+*p = (raise == lambda - *p) ? lambda : *p + raise;
+return(TRUE);
+}
+
+#ifdef	CAPACITY
+/*
+The free slots of w priced below floor bid in turn for the lhs nodes
+they gain most by, taking w's other slots up with them.
+*/
+
+static	void	rhs_bid(w, lambda, floor)
+
+rhs_ptr	w;
+double	lambda, floor;
+
+{
+unsigned	j = w - head_rhs_node, low, best;
+#ifdef	QUICK_MIN
+unsigned	k;
+#endif
+double		d1, d2, p;
+lhs_ptr		u;
+
+for (;;)
+  {
+  for (low = 0; low < w->cap; low++)
+    if ((w->slots[low].mate == NULL) && (w->slots[low].p < floor))
+      break;
+  if (low == w->cap)
+    break;
+  p = w->slots[low].p;
+  offers(w, p, &best, &d1, &d2);
+  if (bid(&p, d1, d2, lambda) && (best != NO_OFFER))
+    {
+    u = rev_tail[best];
+    leave(u, floor);
+    u->matched = rev_arc[best];
+    u->slot = low;
+    w->slots[low].mate = u;
+    }
+  cap_raise(w, p);
+  }
+queued[j] = FALSE;
+#ifdef	QUICK_MIN
+for (k = rev_first[j]; k != rev_first[j + 1]; k++)
+  mark_stale(rev_tail[k]);
+#endif
+}
+#else	/* CAPACITY */
+/*
+The free rhs node w bids for the lhs node it gains most by.
+*/
+
+static	void	rhs_bid(w, lambda, floor)
+
+rhs_ptr	w;
+double	lambda, floor;
+
+{
+unsigned	best;
+#ifdef	QUICK_MIN
+unsigned	j = w - head_rhs_node, k;
+#endif
+double		d1, d2;
+lhs_ptr		u;
+
+offers(w, w->p, &best, &d1, &d2);
+if (bid(&w->p, d1, d2, lambda) && (best != NO_OFFER))
+  {
+  u = rev_tail[best];
+  leave(u, floor);
+  u->matched = rev_arc[best];
+  w->matched = u;
+  }
+#ifdef	QUICK_MIN
+for (k = rev_first[j]; k != rev_first[j + 1]; k++)
+  mark_stale(rev_tail[k]);
+#endif
+}
+#endif	/* CAPACITY */
+
+#ifdef	IMPERFECT
+/*
+The free null node of v bids for v, its only neighbor.
+*/
+
+static	void	null_bid(v, lambda, floor)
+
+lhs_ptr	v;
+double	lambda, floor;
+
+{
+if (bid(&v->null_p, -v->null_p - match_pref(v), NO_BID, lambda))
+  {
+  leave(v, floor);
+  v->matched = NULL;
+  }
+}
+#endif
+
+/*
+Called by refine() once no node is active: raise the free nodes priced
+below the matched ones.
+*/
+
+void	rect_settle()
+
+{
+#if	defined(IMPERFECT) || defined(QUICK_MIN)
+lhs_ptr	v;
+#endif
+rhs_ptr	w;
+double	lambda, floor;
+int	any_matched = FALSE;
+long	i;
+#ifdef	CAPACITY
+unsigned	k;
+#endif
+
+if (rev_first == NULL)
+  rect_init();
+lambda = 0.0;
+for (w = head_rhs_node; w != tail_rhs_node; w++)
+#ifdef	CAPACITY
+  for (k = 0; k < w->cap; k++)
+    if (w->slots[k].mate && (!any_matched || (w->slots[k].p > lambda)))
+      {
+      lambda = w->slots[k].p;
+      any_matched = TRUE;
+      }
+#else
+  if (w->matched && (!any_matched || (w->p > lambda)))
+    {
+    lambda = w->p;
+    any_matched = TRUE;
+    }
+#endif
+#ifdef	IMPERFECT
+for (v = head_lhs_node; v != tail_lhs_node; v++)
+  if ((v->matched == NULL) && (!any_matched || (v->null_p > lambda)))
+    {
+    lambda = v->null_p;
+    any_matched = TRUE;
+    }
+#endif
+if (!any_matched)
+  return;
+floor = lambda - (epsilon > min_epsilon ? epsilon : 0.0);
+
+bidders_n = 0;
+for (w = head_rhs_node; w != tail_rhs_node; w++)
+#ifdef	CAPACITY
+  for (k = 0; k < w->cap; k++)
+    if ((w->slots[k].mate == NULL) && (w->slots[k].p < floor))
+      {
+      queued[w - head_rhs_node] = TRUE;
+      bidders[bidders_n++] = w - head_rhs_node;
+      break;
+      }
+#else
+  if ((w->matched == NULL) && (w->p < floor))
+    bidders[bidders_n++] = w - head_rhs_node;
+#endif
+#ifdef	IMPERFECT
+for (v = head_lhs_node; v != tail_lhs_node; v++)
+  if (v->matched && (v->null_p < floor))
+    bidders[bidders_n++] = -(long) (v - head_lhs_node) - 1;
+#endif
+while (bidders_n > 0)
+  {
+  i = bidders[--bidders_n];
+#ifdef	IMPERFECT
+  if (i < 0)
+    {
+    null_bid(head_lhs_node + (-i - 1), lambda, floor);
+    continue;
+    }
+#endif
+  rhs_bid(head_rhs_node + i, lambda, floor);
+  }
+
+#ifdef	QUICK_MIN
+while (stale_n > 0)
+  {
+  v = stale_list[--stale_n];
+  stale[v - head_lhs_node] = FALSE;
+  best_build(v);
+  }
+#endif
+}
+
+void	display_rect()
+
+{
+rhs_ptr	w;
+unsigned	free_rhs = 0;
+#ifdef	CAPACITY
+unsigned	k;
+#endif
+#ifdef	IMPERFECT
+lhs_ptr	v;
+unsigned	free_lhs = 0;
+
+for (v = head_lhs_node; v != tail_lhs_node; v++)
+  if (v->matched == NULL)
+    free_lhs++;
+#endif
+for (w = head_rhs_node; w != tail_rhs_node; w++)
+#ifdef	CAPACITY
+  for (k = 0; k < w->cap; k++)
+    if (w->slots[k].mate == NULL)
+      free_rhs++;
+#else
+  if (w->matched == NULL)
+    free_rhs++;
+#endif
+#if	defined(IMPERFECT) && defined(CAPACITY)
+(void) printf("|>   %u lhs nodes and %u units of rhs capacity left unmatched\n",
+	      free_lhs, free_rhs);
+#elif	defined(IMPERFECT)
+/*
+The counts are reported by input side; parse() may have swapped them.
+*/
+(void) printf("|>   %u lhs nodes and %u rhs nodes left unmatched\n",
+	      in_swap ? free_rhs : free_lhs, in_swap ? free_lhs : free_rhs);
+#elif	defined(CAPACITY)
+(void) printf("|>   %u units of rhs capacity left unmatched\n", free_rhs);
+#else
+(void) printf("|>   %u %s nodes left unmatched\n", free_rhs,
+	      in_swap ? "lhs" : "rhs");
+#endif
+(void) printf("|>   %u reverse bids: %u won, %u settled at lambda\n",
+	      bids, raises, settles);
+}
@@ -1,4 +1,20 @@
 #include	<stdio.h>
+#if	defined(PAR_REFINE) || defined(PIPELINE_EPS)
+#include	<sched.h>
+#endif
+#ifdef	DET_PAR_REFINE
+#include	<stdlib.h>
+#endif
+#if	defined(PRICE_ORDER) || defined(WARM_START) || \
+	defined(INCREMENTAL) || defined(DYNAMIC_NODES) || \
+	defined(INIT_GREEDY) || defined(INIT_AUCTION) || defined(INIT_DUAL)
+#include	<math.h>
+#endif
+#if	defined(WARM_START) || defined(INCREMENTAL) || \
+	defined(DYNAMIC_NODES) || defined(INIT_GREEDY) || \
+	defined(INIT_AUCTION) || defined(INIT_DUAL)
+#include	<float.h>
+#endif
 #include	"csa_types.h"
 #include	"csa_defs.h"
 
@@ -49,6 +65,14 @@ extern	WORK_TYPE	po_work_thresh;
 extern	int		check_po_arcs();
 #endif
 
+#ifdef	RECT_ASSIGN
+extern	void		rect_settle();
+#endif
+#ifdef	CAPACITY
+extern	void		cap_push(), cap_clear();
+extern	double		cap_second();
+#endif
+
 #if	defined(DEBUG) && defined(CHECK_EPS_OPT)
 extern	void		check_e_o();
 #endif
@@ -60,14 +84,59 @@ extern	rhs_ptr		head_rhs_node;
 extern	char		*st_pop(), *deq();
 
 extern	unsigned	myclock();
-extern	unsigned	refine_time;
-extern	unsigned	double_pushes, pushes, relabelings, refines;
+extern	PAR_LOCAL unsigned	refine_time;
+extern	PAR_LOCAL unsigned	double_pushes, pushes, relabelings, refines;
 #ifdef	QUICK_MIN
-extern	unsigned	rebuilds, scans, non_scans;
+extern	PAR_LOCAL unsigned	rebuilds, scans, non_scans;
 #endif
 #ifdef	EXPLICIT_LHS_PRICES
 extern	unsigned	unnec_rel;
 #endif
+#ifdef	BATCH_REFINE
+extern	unsigned	batches, batch_conflicts;
+#endif
+#ifdef	PAR_REFINE
+extern	unsigned	par_retries;
+extern	void		par_run();
+#ifdef	CHECK_EPS_OPT
+extern	void		check_e_o();
+#endif
+#endif
+#ifdef	DET_PAR_REFINE
+extern	unsigned	num_threads;
+extern	unsigned	det_rounds, det_conflicts;
+extern	void		par_run(), par_barrier();
+extern	char		*nomem_msg;
+#ifdef	CHECK_EPS_OPT
+extern	void		check_e_o();
+#endif
+#endif
+#ifdef	WARM_START
+extern	int		warm_keep();
+#endif
+#ifdef	INIT_MATCH
+extern	int		init_keep();
+#endif
+#ifdef	DEGREE_STATS
+extern	double		fine_clock();
+extern	unsigned	deg_calls[];
+extern	double		deg_time[];
+#endif
+#ifdef	PIPELINE_EPS
+extern	unsigned	num_threads;
+extern	unsigned	pipe_crossings, pipe_syncs;
+extern	double		pipe_sync_time, pipe_refine_idle, pipe_update_idle;
+extern	double		fine_clock();
+extern	void		par_run(), par_fold_counts(), update_block();
+
+/*
+nodes before pipe_updated have been updated for the current epsilon,
+and nodes before pipe_stop are in the blocks being refined. Outside
+pipelined refines, both are tail_lhs_node.
+*/
+static	lhs_ptr		pipe_updated, pipe_stop;
+static	void		pipe_cross();
+#endif
 
 #ifdef	QUICK_MIN
 void	best_build(v)
@@ -122,6 +191,13 @@ for (; a != a_stop; a++)
   			       v->best[NUM_BEST - 1]->head->p))
         {
         sort_insert(v->best, NUM_BEST, a, red_cost, NUM_BEST);
+#ifdef	PAR_REFINE
+	/*
+	Other threads may have raised the reduced cost of the arc we
+	just pushed out of best[] above the bound we already have.
+	*/
+	if (save_max < v->next_best)
+#endif
         v->next_best = save_max;
         }
       else
@@ -132,21 +208,88 @@ for (; a != a_stop; a++)
 }
 #endif
 
-/* Assume v has excess (is unassigned) and do a double push from v. */
+#if	defined(WARM_START) || defined(INCREMENTAL) || defined(INIT_MATCH)
+/*
+Amount by which the partial reduced cost of v's matching arc exceeds
+the smallest one among its other priced-in arcs.
+*/
 
-void	double_push(v)
+double	match_gap(v)
+
+lhs_ptr	v;
+
+{
+lr_aptr	a, a_stop = (v + 1)->priced_out;
+double	m_pref = v->matched->c - v->matched->head->p, pref, min_pref;
+int	any = FALSE;
+
+min_pref = 0.0;
+for (a = v->first; a != a_stop; a++)
+  if (a != v->matched)
+    {
+    pref = a->c - a->head->p;
+    if (!any || (pref < min_pref))
+      min_pref = pref;
+    any = TRUE;
+    }
+return(any && (m_pref > min_pref) ? m_pref - min_pref : 0.0);
+}
+
+/*
+Whether v's matching arc is epsilon-optimal, allowing for rounding in
+the prices, which is large next to epsilon when the costs are.
+*/
+
+int	match_holds(v)
+
+lhs_ptr	v;
+
+{
+lr_aptr	a = v->matched;
+
+return(match_gap(v) <=
+       epsilon + 8.0 * DBL_EPSILON * (fabs(a->c) + fabs(a->head->p)));
+}
+#endif
+
+#ifdef	DEGREE_KERNELS
+/*
+One step of the minimum/second-minimum computation in double_push()
+for the arc a, written so the compiler can use conditional moves
+instead of branches.
+*/
+#define	dk_step(a) \
+{\
+red_cost = (a)->c - (a)->head->p;\
+dk_less = (v_pref > red_cost);\
+v_second = dk_less ? v_pref : (v_second > red_cost ? red_cost : v_second);\
+adm = dk_less ? (a) : adm;\
+v_pref = dk_less ? red_cost : v_pref;\
+}
+#endif
+
+/*
+Part I of a double push from v. Returns adm, and sets *pref to adm's
+partial reduced cost and *gap to adm_gap. Nothing is modified here
+except (in the QUICK_MIN case) v's best-list, so part I can be done
+for several nodes before part II is done for any of them.
+*/
+
+static	lr_aptr	find_adm(v, pref, gap)
 
 lhs_ptr	v;
+double	*pref, *gap;
 
 {
-double	v_pref, v_second, red_cost, adm_gap;
+double	v_pref, v_second, red_cost;
 lr_aptr	a, a_stop, adm;
-rhs_ptr	w;
-lhs_ptr	u;
 #ifdef	QUICK_MIN
 unsigned	i;
 lr_aptr		*check_arc;
 #endif
+#ifdef	DEGREE_KERNELS
+int		dk_less;
+#endif
 
 #ifdef	DEBUG
 (void) printf("%lu p's, %lu dp's: dp on %ld ", pushes, double_pushes,
@@ -162,12 +305,46 @@ Begin part I: Compute the following:
     arc.
 */
 
+#ifdef	DEGREE_KERNELS
+if (v->node_info.deg_class <= MAX_KERNEL_DEG)
+  {
+  /*
+  Straight-line computation for nodes of small priced-in degree:
+  the same minimum and second minimum the loop below would find, with
+  neither a loop nor data-dependent branches.
+  */
+#ifdef	QUICK_MIN
+  scans++;
+#endif
+  a = v->first;
+  v_pref = a->c - a->head->p;
+  v_second = v_pref + epsilon * (po_cost_thresh + 1.0);
+  adm = a;
+  switch (v->node_info.deg_class)
+    {
+    case 4:
+      dk_step(a + 1);
+      dk_step(a + 2);
+      dk_step(a + 3);
+      break;
+    case 3:
+      dk_step(a + 1);
+      dk_step(a + 2);
+      break;
+    case 2:
+      dk_step(a + 1);
+      break;
+    }
+  }
+else
+#endif
 #ifdef	QUICK_MIN
 if (v->node_info.few_arcs)
+#endif
   {
+#ifdef	QUICK_MIN
   scans++;
 #endif
-
   /*
   If the input problem is feasible, it is never the case that
   (a_stop == a) after the following two lines because we never get
@@ -191,9 +368,8 @@ if (v->node_info.few_arcs)
       }
     else if (v_second > red_cost)
       v_second = red_cost;
-
-#ifdef	QUICK_MIN
   }
+#ifdef	QUICK_MIN
 else
   {
   /*
@@ -241,13 +417,83 @@ else
     v_second = adm->c - adm->head->p;
     adm = v->best[0];
     v_pref = adm->c - adm->head->p;
+#ifdef	PAR_REFINE
+    /*
+    Other threads may have lowered prices since best_build() sorted
+    best[], so its order can't be trusted. Take the minimum over the
+    whole list again, and bound v_second by next_best, which remains
+    a lower bound for the arcs not in the list (though no longer
+    necessarily an upper bound for the ones in it).
+    */
+    if (v_pref > v_second)
+      {
+      adm = v->best[1];
+      red_cost = v_second;
+      v_second = v_pref;
+      v_pref = red_cost;
+      }
+#if	(NUM_BEST > 2)
+    for (i = NUM_BEST - 2, check_arc = &v->best[2]; i > 0; i--, check_arc++)
+      {
+      a = *check_arc;
+      if (v_pref > (red_cost = a->c - a->head->p))
+	{
+	v_second = v_pref;
+	v_pref = red_cost;
+	adm = a;
+	}
+      else if (v_second > red_cost)
+	v_second = red_cost;
+      }
+#endif
+    if (v_pref > v->next_best)
+      {
+      /*
+      The bound is below even our minimum, so an arc outside best[]
+      may be the admissible one; fall back on a full scan.
+      */
+      a_stop = (v+1)->priced_out;
+      a = v->first;
+      v_pref = a->c - a->head->p;
+      v_second = v_pref + epsilon * (po_cost_thresh + 1.0);
+      adm = a;
+      for (a++; a != a_stop; a++)
+	if (v_pref > (red_cost = a->c - a->head->p))
+	  {
+	  v_second = v_pref;
+	  v_pref = red_cost;
+	  adm = a;
+	  }
+	else if (v_second > red_cost)
+	  v_second = red_cost;
+      }
+    else if (v_second > v->next_best)
+      v_second = v->next_best;
+#endif
     }
   else
     non_scans++;
   }
 #endif
 
-adm_gap = v_second - v_pref;
+*pref = v_pref;
+*gap = v_second - v_pref;
+return(adm);
+}
+
+/*
+Part II of a double push from v, given the results of part I.
+*/
+
+static	void	dp_apply(v, adm, v_pref, adm_gap)
+
+lhs_ptr	v;
+lr_aptr	adm;
+double	v_pref, adm_gap;
+
+{
+rhs_ptr	w;
+lhs_ptr	u;
 
 #ifdef	EXPLICIT_LHS_PRICES
 if (v->p + v_pref > epsilon)
@@ -275,6 +521,10 @@ change the matching, but we reset the value of adm_gap so that the
 (v, w) arc will be priced out.
 */
 w = adm->head;
+#ifdef	PIPELINE_EPS
+if ((u = w->matched) && (u >= pipe_stop))
+  pipe_cross(u);
+#endif
 if ((u = w->matched))
   /*
   If w's matched arc is priced in, go ahead and unmatch (u, w) and
@@ -286,7 +536,16 @@ if ((u = w->matched))
     pushes += 2;
     double_pushes++;
     u->matched = NULL;
-    make_active(u);
+#ifdef	PIPELINE_EPS
+    /*
+    A node in a block not yet being refined waits for its block's
+    turn.
+    */
+    if (u >= pipe_stop)
+      total_e--;
+    else
+#endif
+    make_active_dropped(u, adm_gap + epsilon);
     v->matched = adm;
     w->matched = v;
     }
@@ -320,8 +579,626 @@ is chosen so that the arc just matched has implicit reduced cost
 */
 relabelings++;
 w->p -= adm_gap + epsilon;
+#ifdef	CAPACITY
+cap_push(w);
+#endif
+}
+
+#ifdef	IMPERFECT
+/*
+Push from v to its null node, whose partial reduced cost null_pref is
+less than that of every arc out of v, the least of which is v_pref.
+The null node is v's alone, so it is always free.
+*/
+
+static	void	null_push(v, null_pref, v_pref)
+
+lhs_ptr	v;
+double	null_pref, v_pref;
+
+{
+total_e--;
+pushes++;
+relabelings++;
+v->null_p -= v_pref - null_pref + epsilon;
+}
+#endif
+
+/* Assume v has excess (is unassigned) and do a double push from v. */
+
+void	double_push(v)
+
+lhs_ptr	v;
+
+{
+double	v_pref, adm_gap;
+lr_aptr	adm;
+#ifdef	IMPERFECT
+double	null_pref = -v->null_p;
+
+/*
+A node with no arcs can only be left unmatched.
+*/
+if (v->first == (v+1)->priced_out)
+  {
+  total_e--;
+  return;
+  }
+#endif
+
+adm = find_adm(v, &v_pref, &adm_gap);
+#ifdef	CAPACITY
+/*
+The second slot of adm's head is as good a second choice as any other
+arc.
+*/
+if ((adm->head->cap > 1) &&
+    (adm->head->p - cap_second(adm->head) < adm_gap))
+  adm_gap = adm->head->p - cap_second(adm->head);
+#endif
+#ifdef	IMPERFECT
+if (null_pref < v_pref)
+  {
+  null_push(v, null_pref, v_pref);
+  return;
+  }
+if (null_pref < v_pref + adm_gap)
+  adm_gap = null_pref - v_pref;
+#endif
+dp_apply(v, adm, v_pref, adm_gap);
+}
+
+#ifdef	BATCH_REFINE
+/*
+Double push from a batch of up to BATCH_SIZE active nodes. Part I is
+done for the whole batch first; since it only reads prices, the
+computations for different nodes are independent, and the memory
+accesses of one overlap with those of the others. Then part II is done
+for each node in turn. Because prices only decrease, an arc's reduced
+cost can only have increased since part I, so the gap computed for a
+node remains safe unless the price of its adm's head has changed in
+the meantime. A node whose adm's head was relabeled earlier in the
+batch loses the conflict and goes back into the active set.
+*/
+
+static	void	batch_push()
+
+{
+static	lhs_ptr	batch_v[BATCH_SIZE];
+static	lr_aptr	batch_adm[BATCH_SIZE];
+static	double	batch_pref[BATCH_SIZE], batch_gap[BATCH_SIZE];
+static	unsigned	batch_num = 0;
+unsigned	i, size;
+rhs_ptr		w;
+
+size = total_e - EXCESS_THRESH;
+if (size > BATCH_SIZE)
+  size = BATCH_SIZE;
+for (i = 0; i < size; i++)
+  get_active_node(batch_v[i]);
+for (i = 0; i < size; i++)
+  batch_adm[i] = find_adm(batch_v[i], &batch_pref[i], &batch_gap[i]);
+
+batches++;
+batch_num++;
+for (i = 0; i < size; i++)
+  {
+  w = batch_adm[i]->head;
+  if (w->batch == batch_num)
+    {
+    batch_conflicts++;
+    make_active(batch_v[i]);
+    }
+  else
+    {
+    w->batch = batch_num;
+    dp_apply(batch_v[i], batch_adm[i], batch_pref[i], batch_gap[i]);
+    }
+  }
+}
+#endif
+
+#if	defined(PAR_REFINE) || defined(DET_PAR_REFINE)
+/*
+addresses of the main thread's counters, which the other threads add
+theirs to when they finish.
+*/
+static	unsigned	*main_count[6];
+
+static	void	set_main_counts()
+
+{
+main_count[0] = &double_pushes;
+main_count[1] = &pushes;
+main_count[2] = &relabelings;
+#ifdef	QUICK_MIN
+main_count[3] = &rebuilds;
+main_count[4] = &scans;
+main_count[5] = &non_scans;
+#endif
+}
+
+static	void	fold_counts(id)
+
+unsigned	id;
+
+{
+unsigned	*count[6];
+int		i;
+
+if (id > 0)
+  {
+  count[0] = &double_pushes;
+  count[1] = &pushes;
+  count[2] = &relabelings;
+#ifdef	QUICK_MIN
+  count[3] = &rebuilds;
+  count[4] = &scans;
+  count[5] = &non_scans;
+#endif
+  for (i = 0; i < 6; i++)
+    if (main_count[i])
+      {
+      (void) __sync_fetch_and_add(main_count[i], *count[i]);
+      *count[i] = 0;
+      }
+  }
+}
+#endif
+
+#ifdef	PAR_REFINE
+/*
+Multi-threaded refine. Each thread takes active nodes from the shared
+lock-free stack and double-pushes from them. Part I reads prices
+without synchronization; since prices only decrease, the reduced
+costs it computes can only be too low, which makes the gap safe for
+every arc but adm. Part II then claims adm's head w by changing w's
+matched and p fields together in one compare-and-swap, which succeeds
+only if w's price is still the one part I saw. A thread that loses the
+race just starts over on the same node. A thread that displaces a node
+continues with that node itself, exactly as the stack ordering would
+have it, so most pushes never touch the shared stack.
+*/
+
+
+/*
+Double push from v and return the node it displaced, if any.
+*/
+
+static	lhs_ptr	par_double_push(v)
+
+lhs_ptr	v;
+
+{
+double		v_pref, adm_gap;
+lr_aptr		adm;
+rhs_ptr		w;
+rhs_state	old, new;
+
+for (;;)
+  {
+  adm = find_adm(v, &v_pref, &adm_gap);
+  w = adm->head;
+  old.f.matched = w->matched;
+  old.f.p = w->p;
+  if (adm->c - old.f.p == v_pref)
+    {
+    new.f.matched = v;
+    new.f.p = old.f.p - (adm_gap + epsilon);
+    /*
+    v->matched must be set before w->matched points to v, since
+    another thread may displace v as soon as it does.
+    */
+    v->matched = adm;
+    if (__sync_bool_compare_and_swap((unsigned __int128 *) &w->matched,
+				     old.bits, new.bits))
+      break;
+    }
+  (void) __sync_fetch_and_add(&par_retries, 1);
+  }
+
+relabelings++;
+if (old.f.matched)
+  {
+  pushes += 2;
+  double_pushes++;
+  old.f.matched->matched = NULL;
+  }
+else
+  {
+  (void) __sync_fetch_and_sub(&total_e, 1);
+  pushes++;
+  }
+return(old.f.matched);
+}
+
+static	void	par_refine_thread(id)
+
+unsigned	id;
+
+{
+lhs_ptr		v = NULL;
+
+for (;;)
+  {
+  if (v == NULL)
+    {
+    get_active_node(v);
+#ifdef	WORK_STEALING
+    if (v == NULL)
+      break;
+#else
+    if (v == NULL)
+      {
+      /*
+      Nothing to do right now; we're through once every node is
+      matched. Until then, another thread is still working on a
+      chain of double pushes.
+      */
+      if (*((volatile unsigned *) &total_e) == 0)
+	break;
+      (void) sched_yield();
+      continue;
+      }
+#endif
+    }
+  v = par_double_push(v);
+  }
+
+fold_counts(id);
+}
+#endif
+
+#ifdef	DET_PAR_REFINE
+/*
+Deterministic multi-threaded refine, done in rounds. In each round,
+part I is done for every active node against the same prices, and
+each rhs node proposed to goes to the lowest-addressed lhs node
+proposing to it. Then part II is done for the winners. As in the
+BATCH_REFINE case, prices only decrease, so the gap a winner computed
+stays safe; and no two winners share a head. The losers, and the
+nodes the winners displace, are the next round's active nodes, in an
+order fixed by their predecessors' positions in this round's list.
+The matching and every counter therefore come out the same whatever
+the number of threads and however they are scheduled. Rounds with
+fewer than PAR_CHUNK active nodes are done by the calling thread
+alone.
+*/
+
+static	lhs_ptr		*det_v;		/* this round's active nodes */
+static	lhs_ptr		*det_next;	/* two slots per active node */
+static	lr_aptr		*det_adm;
+static	double		*det_pref, *det_gap;
+static	unsigned	det_n;		/* number of active nodes */
+
+/*
+Make v the proposer to w unless a lower-addressed node is.
+*/
+
+static	void	det_claim(w, v)
+
+rhs_ptr	w;
+lhs_ptr	v;
+
+{
+lhs_ptr	c;
+
+while (((c = w->claim) == NULL) || (v < c))
+  if (__sync_bool_compare_and_swap(&w->claim, c, v))
+    break;
+}
+
+/*
+Part I for active nodes first, ..., stop - 1 of this round.
+*/
+
+static	void	det_propose(first, stop)
+
+unsigned	first, stop;
+
+{
+unsigned	i;
+
+for (i = first; i < stop; i++)
+  {
+  det_adm[i] = find_adm(det_v[i], &det_pref[i], &det_gap[i]);
+  det_claim(det_adm[i]->head, det_v[i]);
+  }
+}
+
+/*
+Part II for the winners among active nodes first, ..., stop - 1.
+The node in position i, if it lost, or the node it displaced goes in
+det_next[2 * i] or det_next[2 * i + 1] respectively.
+*/
+
+static	void	det_apply(first, stop)
+
+unsigned	first, stop;
+
+{
+unsigned	i;
+lhs_ptr		u, v;
+rhs_ptr		w;
+
+for (i = first; i < stop; i++)
+  {
+  v = det_v[i];
+  w = det_adm[i]->head;
+  det_next[2 * i] = det_next[2 * i + 1] = NULL;
+  if (w->claim != v)
+    {
+    det_next[2 * i] = v;
+    continue;
+    }
+  if ((u = w->matched))
+    {
+    pushes += 2;
+    double_pushes++;
+    u->matched = NULL;
+    det_next[2 * i + 1] = u;
+    }
+  else
+    pushes++;
+  v->matched = det_adm[i];
+  w->matched = v;
+  relabelings++;
+  w->p -= det_gap[i] + epsilon;
+  }
+}
+
+/*
+Clear the claims and gather the next round's active nodes.
+*/
+
+static	void	det_next_round()
+
+{
+unsigned	i, j;
+
+det_rounds++;
+for (i = 0; i < det_n; i++)
+  det_adm[i]->head->claim = NULL;
+for (i = j = 0; i < 2 * det_n; i += 2)
+  {
+  if (det_next[i])
+    {
+    det_conflicts++;
+    det_v[j++] = det_next[i];
+    }
+  if (det_next[i + 1])
+    det_v[j++] = det_next[i + 1];
+  }
+total_e = det_n = j;
+}
+
+static	void	det_refine_thread(id)
+
+unsigned	id;
+
+{
+unsigned	first, stop;
+
+/*
+det_n changes only between the second and third barriers, so every
+thread sees the same value here.
+*/
+while (det_n >= PAR_CHUNK)
+  {
+  first = (unsigned) ((unsigned long) det_n * id / num_threads);
+  stop = (unsigned) ((unsigned long) det_n * (id + 1) / num_threads);
+  det_propose(first, stop);
+  par_barrier();
+  det_apply(first, stop);
+  par_barrier();
+  if (id == 0)
+    det_next_round();
+  par_barrier();
+  }
+fold_counts(id);
 }
 
+static	void	det_refine()
+
+{
+unsigned	n_lhs;
+void	exit();
+
+if (det_v == NULL)
+  {
+  n_lhs = tail_lhs_node - head_lhs_node;
+  det_v = (lhs_ptr *) malloc(n_lhs * sizeof(lhs_ptr));
+  det_next = (lhs_ptr *) malloc(2 * n_lhs * sizeof(lhs_ptr));
+  det_adm = (lr_aptr *) malloc(n_lhs * sizeof(lr_aptr));
+  det_pref = (double *) malloc(n_lhs * sizeof(double));
+  det_gap = (double *) malloc(n_lhs * sizeof(double));
+  if ((det_v == NULL) || (det_next == NULL) || (det_adm == NULL) ||
+      (det_pref == NULL) || (det_gap == NULL))
+    {
+    (void) printf("%s", nomem_msg);
+    exit(9);
+    }
+  }
+
+for (det_n = 0; det_n < total_e; det_n++)
+  get_active_node(det_v[det_n]);
+if ((num_threads > 1) && (det_n >= PAR_CHUNK))
+  {
+  set_main_counts();
+  par_run(det_refine_thread);
+  }
+while (det_n > 0)
+  {
+  det_propose(0, det_n);
+  det_apply(0, det_n);
+  det_next_round();
+  }
+}
+#endif
+
+#ifdef	PIPELINE_EPS
+/*
+Pipelined refine, for every scaling phase but the first. The lhs
+nodes are split into PIPE_BLOCKS blocks of consecutive nodes. One
+thread does update_epsilon()'s price-ins and price-outs a block at a
+time, while this one refines each block as soon as it has been
+updated: it unmatches the block's nodes as refine() does all nodes,
+then double-pushes until every node in the blocks so far is matched.
+Nodes in later blocks keep their old matches meanwhile. A double push
+that displaces one of them crosses blocks, and the displaced node is
+left for its own block's turn. But if that block hasn't been updated
+yet, we must wait for it first, since the update assumes the node is
+matched and may be changing its matching arc. The other thread reads
+the prices of rhs nodes we may be lowering; since prices only drop,
+an arc it prices out on the strength of an old price would have been
+priced out on the new one.
+*/
+
+static	lhs_ptr	pipe_block_end(v)
+
+lhs_ptr	v;
+
+{
+unsigned	size = (tail_lhs_node - head_lhs_node + PIPE_BLOCKS - 1) /
+		       PIPE_BLOCKS;
+
+return(tail_lhs_node - v > size ? v + size : tail_lhs_node);
+}
+
+/*
+Wait until node u has been updated, and return the time we waited.
+*/
+
+static	double	pipe_wait(u)
+
+lhs_ptr	u;
+
+{
+double	start;
+
+if (u < *((lhs_ptr volatile *) &pipe_updated))
+  return(0.0);
+start = fine_clock();
+while (u >= *((lhs_ptr volatile *) &pipe_updated))
+  (void) sched_yield();
+__sync_synchronize();
+return(fine_clock() - start);
+}
+
+/*
+A double push is about to displace u, which is in a block not yet
+being refined.
+*/
+
+static	void	pipe_cross(u)
+
+lhs_ptr	u;
+
+{
+pipe_crossings++;
+if (u >= *((lhs_ptr volatile *) &pipe_updated))
+  {
+  pipe_syncs++;
+  pipe_sync_time += pipe_wait(u);
+  }
+}
+
+static	void	pipe_update_thread()
+
+{
+lhs_ptr	v, v_stop;
+double	done;
+
+for (v = head_lhs_node; v != tail_lhs_node; v = v_stop)
+  {
+  v_stop = pipe_block_end(v);
+  update_block(v, v_stop);
+  __sync_synchronize();
+  *((lhs_ptr volatile *) &pipe_updated) = v_stop;
+  }
+/*
+Whatever time is left until the refine ends is idle.
+*/
+done = fine_clock();
+while (*((lhs_ptr volatile *) &pipe_stop) != NULL)
+  (void) sched_yield();
+pipe_update_idle += fine_clock() - done;
+}
+
+static	void	pipe_refine_thread()
+
+{
+lhs_ptr	v, b, b_stop;
+
+for (b = head_lhs_node; b != tail_lhs_node; b = b_stop)
+  {
+  b_stop = pipe_block_end(b);
+  pipe_refine_idle += pipe_wait(b_stop - 1);
+  pipe_stop = b_stop;
+  for (v = b; v != b_stop; v++)
+    {
+    if (v->matched && v->matched->head->node_info.priced_in)
+      {
+      v->matched->head->matched = NULL;
+      v->matched = NULL;
+      }
+    if (v->matched == NULL)
+      {
+      total_e++;
+      make_active(v);
+      }
+    }
+  while (total_e > 0)
+    {
+    get_active_node(v);
+    double_push(v);
+    }
+  }
+/*
+Tell the updating thread we're through.
+*/
+*((lhs_ptr volatile *) &pipe_stop) = NULL;
+}
+
+static	void	pipe_thread(id)
+
+unsigned	id;
+
+{
+if (id == 0)
+  pipe_refine_thread();
+else if (id == 1)
+  {
+  pipe_update_thread();
+  par_fold_counts(id);
+  }
+}
+
+static	void	pipe_refine()
+
+{
+lhs_ptr	v;
+
+total_e = 0;
+if (num_threads > 1)
+  {
+  pipe_updated = head_lhs_node;
+  par_run(pipe_thread);
+  }
+else
+  {
+  /*
+  With one thread, there's no one to update ahead of us.
+  */
+  for (v = head_lhs_node; v != tail_lhs_node; v = pipe_block_end(v))
+    update_block(v, pipe_block_end(v));
+  pipe_updated = tail_lhs_node;
+  pipe_refine_thread();
+  }
+pipe_updated = pipe_stop = tail_lhs_node;
+}
+#endif
+
 void	refine()
 
 {
@@ -332,9 +1209,22 @@ WORK_TYPE	old_refine_work_upd;
 #ifdef	STRONG_PO
 WORK_TYPE	old_refine_work_po;
 #endif
+#ifdef	DEGREE_STATS
+unsigned	deg_class;
+#endif
 
 refine_time -= myclock();
+#ifdef	PIPELINE_EPS
+if (refines++ > 0)
+  {
+  pipe_refine();
+  refine_time += myclock();
+  return;
+  }
+pipe_updated = pipe_stop = tail_lhs_node;
+#else
 refines++;
+#endif
 /*
 Saturate all negative arcs: Negative arcs are exactly those
 right-to-left matching arcs with negative reduced cost, and there is
@@ -346,7 +1236,13 @@ of EXPLICIT_PRICES.
 total_e = 0;
 for (v = head_lhs_node; v != tail_lhs_node; v++)
   {
-  if (v->matched && v->matched->head->node_info.priced_in)
+  if (v->matched && v->matched->head->node_info.priced_in
+#ifdef	WARM_START
+      && ((refines > 1) || !warm_keep(v))
+#elif	defined(INIT_MATCH)
+      && ((refines > 1) || !init_keep(v))
+#endif
+     )
     {
     v->matched->head->matched = NULL;
     v->matched = NULL;
@@ -357,6 +1253,9 @@ for (v = head_lhs_node; v != tail_lhs_node; v++)
     make_active(v);
     }
   }
+#ifdef	CAPACITY
+cap_clear();
+#endif
 
 #ifdef	USE_P_UPDATE
 old_refine_work_upd = REFINE_WORK;
@@ -365,6 +1264,18 @@ old_refine_work_upd = REFINE_WORK;
 old_refine_work_po = REFINE_WORK;
 #endif
 
+#ifdef	PAR_REFINE
+set_main_counts();
+par_run(par_refine_thread);
+#ifdef	CHECK_EPS_OPT
+check_e_o(epsilon);
+#endif
+#elif	defined(DET_PAR_REFINE)
+det_refine();
+#ifdef	CHECK_EPS_OPT
+check_e_o(epsilon);
+#endif
+#else	/* PAR_REFINE */
 #ifdef	STRONG_PO
 while ((total_e > 0) || (old_refine_work_po = REFINE_WORK,
 			 !check_po_arcs()))
@@ -372,6 +1283,13 @@ while ((total_e > 0) || (old_refine_work_po = REFINE_WORK,
 while (total_e > EXCESS_THRESH)
 #endif
   {
+#ifdef	ANYTIME
+  if (anytime_out())
+    {
+    refine_time += myclock();
+    return;
+    }
+#endif
 #ifdef	USE_P_UPDATE
   if (REFINE_WORK - old_refine_work_upd > upd_work_thresh)
     {
@@ -392,14 +1310,31 @@ while (total_e > EXCESS_THRESH)
 #endif
     }
 #endif
+#ifdef	BATCH_REFINE
+  batch_push();
+#else
   get_active_node(v);
+#ifdef	DEGREE_STATS
+  deg_class = v->node_info.deg_class;
+  deg_calls[deg_class]++;
+  deg_time[deg_class] -= fine_clock();
   double_push(v);
+  deg_time[deg_class] += fine_clock();
+#else
+  double_push(v);
+#endif
+#endif
   }
 
+#endif	/* PAR_REFINE */
+
 #ifdef	USE_SP_AUG
 if (total_e > 0)
   sp_aug();
 #endif
+#ifdef	RECT_ASSIGN
+rect_settle();
+#endif
 
 refine_time += myclock();
 }
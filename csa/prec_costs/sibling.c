@@ -0,0 +1,34 @@
+#include	<stdio.h>
+#include	<stdlib.h>
+#include	<string.h>
+#include	<limits.h>
+#include	<unistd.h>
+
+/*
+Executables installed next to our own: csa_auto hands its input to
+one of them, and csa_portfolio races several. Our own directory is
+found through /proc/self/exe where there is one, so it doesn't matter
+whether we were run through PATH, a relative name or a symbolic link,
+and through argv0 otherwise.
+
+Write the absolute path of the executable name in our directory to
+path, which has room for PATH_MAX characters. Return whether it can
+be executed.
+*/
+
+int	sibling_path(name, argv0, path)
+
+char	*name, *argv0, *path;
+
+{
+char	self[PATH_MAX], *slash;
+
+if ((realpath("/proc/self/exe", self) == NULL) &&
+    (realpath(argv0, self) == NULL))
+  return(0);
+slash = strrchr(self, '/');
+if (snprintf(path, PATH_MAX, "%.*s/%s", (int) (slash - self), self, name)
+    >= PATH_MAX)
+  return(0);
+return(access(path, X_OK) == 0);
+}
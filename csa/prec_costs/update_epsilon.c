@@ -1,6 +1,12 @@
-#if	defined(DEBUG) || defined(CHECK_EPS_OPT)
+#if	defined(DEBUG) || defined(CHECK_EPS_OPT) || defined(ADAPTIVE_EPS)
 #include	<stdio.h>
 #endif
+#ifdef	ADAPTIVE_EPS
+#include	<math.h>
+#endif
+#ifdef	PAR_UPDATE_EPS
+#include	<stdlib.h>
+#endif
 #include	"csa_types.h"
 #include	"csa_defs.h"
 
@@ -17,17 +23,144 @@ extern	lhs_ptr	head_lhs_node, tail_lhs_node;
 extern	rhs_ptr	head_rhs_node;
 #endif
 #if	defined(USE_PRICE_OUT) || defined(CHECK_EPS_OPT)
-extern	unsigned	refines;
+extern	PAR_LOCAL unsigned	refines;
 #endif
 #ifdef	QUICK_MIN
 extern	void	best_build();
 #endif
+#ifdef	DEGREE_STATS
+extern	unsigned	deg_moves;
+#endif
 
-int	update_epsilon()
+#if	defined(USE_PRICE_OUT) || defined(CHECK_EPS_OPT)
+static	double	po_cutoff;
+#endif
+
+#ifdef	ADAPTIVE_EPS
+/*
+Adaptive scaling: rather than dividing epsilon by scale_factor every
+time, we choose each divisor from the work of the refine before it.
+A refine unmatches every lhs node, so it costs at least one relabeling
+per node; anything beyond that is work repairing the prices, and
+grows with the divisor that led to the refine. Late refines often do
+next to no repair, so their divisor can grow, saving whole refines,
+while refines that turn into price wars call for a smaller one. In the
+USE_PRICE_OUT case the extra work is weighted by the fraction of arcs
+still priced in, since each double push scans only those. The divisor
+moves by at most a factor of two each time, by the square root of the
+ratio of ADAPT_TARGET to the extra work per node, and stays between
+ADAPT_MIN and scale_factor, the bound the bucket sizes and price-out
+thresholds assume.
+*/
+extern	PAR_LOCAL unsigned	relabelings;
+
+#define	MAX_ADAPT_LOG	64
+
+static	double		divisor;
+static	unsigned	last_relabelings;
+static	double		adapt_log[MAX_ADAPT_LOG];
+static	unsigned	adapt_n = 0;
+
+/*
+Called at the start of each scaling run.
+*/
+
+void	adapt_reset()
+
+{
+adapt_n = 0;
+}
+
+static	double	adapt_divisor()
+
+{
+extern	double	scale_factor;
+double	work;
+#ifdef	USE_PRICE_OUT
+lhs_ptr		v;
+unsigned long	out = 0;
+#endif
+
+if (adapt_n == 0)
+  divisor = ADAPT_START;
+else
+  {
+  work = (double) (relabelings - last_relabelings) /
+	 (double) (tail_lhs_node - head_lhs_node) - 1.0;
+#ifdef	USE_PRICE_OUT
+  for (v = head_lhs_node; v != tail_lhs_node; v++)
+    out += v->first - v->priced_out;
+  work *= 1.0 - (double) out /
+		(double) (tail_lhs_node->priced_out - head_lhs_node->priced_out);
+#endif
+  if (work < ADAPT_TARGET / 4.0)
+    work = ADAPT_TARGET / 4.0;
+  else if (work > 4.0 * ADAPT_TARGET)
+    work = 4.0 * ADAPT_TARGET;
+  divisor *= sqrt(ADAPT_TARGET / work);
+  }
+if (divisor < ADAPT_MIN)
+  divisor = ADAPT_MIN;
+if (divisor > scale_factor)
+  divisor = scale_factor;
+last_relabelings = relabelings;
+if (adapt_n < MAX_ADAPT_LOG)
+  adapt_log[adapt_n] = divisor;
+adapt_n++;
+return(divisor);
+}
+
+void	display_adapt()
+
+{
+unsigned	i;
+
+(void) printf("|>   epsilon divisors:");
+for (i = 0; (i < adapt_n) && (i < MAX_ADAPT_LOG); i++)
+  (void) printf(" %.3g", adapt_log[i]);
+(void) putchar('\n');
+}
+#endif	/* ADAPTIVE_EPS */
+
+#ifdef	PAR_UPDATE_EPS
+/*
+In the PAR_UPDATE_EPS case the pass over lhs nodes is split among
+threads, each claiming a run of nodes at a time with par_claim_lhs().
+Work on a node's own arc list is independent of other nodes, but the
+reverse arcs of an rhs node are shared by all its neighbors, so the
+price-in and price-out macros only note the moves of reverse arcs, and
+par_rev_moves() makes them after the pass in the order the serial pass
+would have (see par.c). A back-arc price-out changes the arc lists of
+nodes the serial pass has yet to reach, so BACK_PRICE_OUT is excluded.
+*/
+extern	void		par_run();
+extern	lhs_ptr		par_claim_lhs();
+extern	void		par_fold_counts();
+
+static	int		fix_in;
+
+#ifdef	STORE_REV_ARCS
+extern	void		par_rev_init(), par_rev_moves();
+
+#undef	price_in_rev
+#undef	price_out_rev
+#define	price_in_rev(a)		defer_rev(a, f_a, REV_IN)
+#define	price_out_rev(a)	defer_rev(a, f_a, REV_OUT)
+#endif	/* STORE_REV_ARCS */
+#endif	/* PAR_UPDATE_EPS */
+
+#if	defined(USE_PRICE_OUT) || defined(CHECK_EPS_OPT)
+/*
+Price in and price out arcs incident to v as appropriate for the new
+epsilon. Return TRUE if an arc had to be fixed in.
+*/
+
+static	int	update_node(v)
+
+lhs_ptr	v;
 
 {
 #ifdef	USE_PRICE_OUT
-double	po_cutoff;
 double	thresh;
 int	one_priced_in;
 #if	defined(QUICK_MIN) && !defined(BACK_PRICE_OUT)
@@ -39,195 +172,339 @@ lhs_ptr	u;
 rhs_ptr	w;
 #endif	/* BACK_PRICE_OUT */
 #endif	/* USE_PRICE_OUT */
-#if	defined(USE_PRICE_OUT) || defined(CHECK_EPS_OPT)
 double	v_price, red_cost;
-lhs_ptr	v;
 lr_aptr	a, a_start, a_stop;
-#endif	/* USE_PRICE_OUT || CHECK_EPS_OPT */
 #ifdef	STRONG_PO
 double	fix_in_thresh;
 #endif	/* STRONG_PO */
+#ifdef	CHECK_EPS_OPT
 extern	double	scale_factor;
-
-int	fix_in = FALSE;
-
-epsilon /= scale_factor;
-
-if (epsilon < min_epsilon) epsilon = min_epsilon;
-
-#ifdef	USE_PRICE_OUT
-po_cutoff = po_cost_thresh * epsilon;
 #endif
+int	fix_in = FALSE;
 
-#if	defined(USE_PRICE_OUT) || defined(CHECK_EPS_OPT)
 /*
-Now if at least one refine has occurred (and hence all lhs nodes are
-matched), check for arcs that should be priced in and price them in,
-and check for arcs that should be priced out and price them out.
+First, save the location of the first priced-in arc so we don't do
+costly computations for any arc twice.
 */
-if (refines > 0)
-  {
-  for (v = head_lhs_node; v != tail_lhs_node; v++)
-    {
-    /*
-    First, save the location of the first priced-in arc so we don't do
-    costly computations for any arc twice.
-    */
-    a_start = v->first;
-    /*
-    Determine the price we will assume v has. We choose the price so the
-    matching arc will have zero partial reduced cost, and this choice
-    enables us to do several things:
-    1) Detect epsilon-optimality by checking that partial reduced costs
-       of non-matching arcs are at least -epsilon;
-    2) Make price-in and price-out decisions in a way that lets us store
-       new costs (with incorporated rhs prices) without any backtracking.
-       Those arcs with reduced cost close to that of the matching arc
-       are priced in, those far away are priced out, and that's that.
-    */
-    v_price = v->matched->head->p - v->matched->c;
+a_start = v->first;
+/*
+Determine the price we will assume v has. We choose the price so the
+matching arc will have zero partial reduced cost, and this choice
+enables us to do several things:
+1) Detect epsilon-optimality by checking that partial reduced costs
+   of non-matching arcs are at least -epsilon;
+2) Make price-in and price-out decisions in a way that lets us store
+   new costs (with incorporated rhs prices) without any backtracking.
+   Those arcs with reduced cost close to that of the matching arc
+   are priced in, those far away are priced out, and that's that.
+*/
+v_price = v->matched->head->p - v->matched->c;
 #ifdef	USE_PRICE_OUT
-    thresh = po_cutoff - v_price;
-    one_priced_in = FALSE;
+thresh = po_cutoff - v_price;
+one_priced_in = FALSE;
 #if	defined(QUICK_MIN) && !defined(BACK_PRICE_OUT)
-    need_best_rebuild = FALSE;
+need_best_rebuild = FALSE;
 #endif	/* QUICK_MIN && !BACK_PRICE_OUT */
 #endif	/* USE_PRICE_OUT */
 #ifdef	STRONG_PO
+/*
+Check for arcs to price in.
+*/
+fix_in_thresh = -epsilon - v_price;
+for (a = v->priced_out; a != v->first; a++)
+  if ((a != v->matched) && ((red_cost = a->c - a->head->p) < thresh))
+    {
+    price_in_unm_arc(v, a);
+    one_priced_in = TRUE;
     /*
-    Check for arcs to price in.
+    If we have a fix-in, we don't have to unmatch the node here,
+    since refine unmatches all nodes initially anyway. Just let
+    main know that refine is needed.
     */
-    fix_in_thresh = -epsilon - v_price;
-    for (a = v->priced_out; a != v->first; a++)
-      if ((a != v->matched) && ((red_cost = a->c - a->head->p) < thresh))
-	{
-	price_in_unm_arc(v, a);
-	one_priced_in = TRUE;
-	/*
-	If we have a fix-in, we don't have to unmatch the node here,
-	since refine unmatches all nodes initially anyway. Just let
-	main know that refine is needed.
-	*/
-	if (red_cost < fix_in_thresh)
-	  fix_in = TRUE;
+    if (red_cost < fix_in_thresh)
+      fix_in = TRUE;
 #if	defined(QUICK_MIN) && !defined(BACK_PRICE_OUT)
-	need_best_rebuild = TRUE;
+    need_best_rebuild = TRUE;
 #endif	/* QUICK_MIN && !BACK_PRICE_OUT */
-	if (a == v->first) break;
-	}
+    if (a == v->first) break;
+    }
 #endif	/* STRONG_PO */
-    a_stop = (v+1)->priced_out;
-    /*
-    For each arc incident to v, decide whether or not to price it out.
-    */
-    for (a = a_start; a != a_stop; a++)
-      {
-      if (a != v->matched)
-	{
-	red_cost = a->c - a->head->p;
+a_stop = (v+1)->priced_out;
+/*
+For each arc incident to v, decide whether or not to price it out.
+*/
+for (a = a_start; a != a_stop; a++)
+  {
+  if (a != v->matched)
+    {
+    red_cost = a->c - a->head->p;
 #ifdef	USE_PRICE_OUT
-	if (red_cost >= thresh)
-	  {
-	  price_out_unm_arc(v, a);
+    if (red_cost >= thresh)
+      {
+      price_out_unm_arc(v, a);
 #if	defined(QUICK_MIN) && !defined(BACK_PRICE_OUT)
-	  need_best_rebuild = TRUE;
+      need_best_rebuild = TRUE;
 #endif	/* QUICK_MIN && !BACK_PRICE_OUT */
-	  }
-	else
-	  {
-	  one_priced_in = TRUE;
+      }
+    else
+      {
+      one_priced_in = TRUE;
 #endif	/* USE_PRICE_OUT */
 #ifdef	CHECK_EPS_OPT
-	  /*
-	  0.01 in the following line because of precision problems
-	  that are ultimately OK, although they make the flow look
-	  non-epsilon-optimal.
-	  */
-	  if (v_price + red_cost < -epsilon * (scale_factor + 0.01))
-	    {
-	    (void) printf("Epsilon optimality violation! c(%ld, %ld)=%lg; epsilon=%lg\n",
-			  v - head_lhs_node + 1, a->head - head_rhs_node + 1,
-			  v_price + red_cost, epsilon);
-	    (void) fflush(stdout);
-	    }
+      /*
+      0.01 in the following line because of precision problems
+      that are ultimately OK, although they make the flow look
+      non-epsilon-optimal.
+      */
+      if (v_price + red_cost < -epsilon * (scale_factor + 0.01))
+	{
+	(void) printf("Epsilon optimality violation! c(%ld, %ld)=%lg; epsilon=%lg\n",
+		      v - head_lhs_node + 1, a->head - head_rhs_node + 1,
+		      v_price + red_cost, epsilon);
+	(void) fflush(stdout);
+	}
 #endif	/* CHECK_EPS_OPT */
 #ifdef	USE_PRICE_OUT
-	  }
-#endif	/* USE_PRICE_OUT */
-	}
       }
+#endif	/* USE_PRICE_OUT */
+    }
+  }
 #ifdef	USE_PRICE_OUT
-    a = v->matched;
+a = v->matched;
 #ifdef	STRONG_PO
-    if (one_priced_in)
-      {
-      if (!a->head->node_info.priced_in)
-	{
-	/*
-	Matching arc is priced out.
-	*/
-	price_in_mch_arc(v, a);
+if (one_priced_in)
+  {
+  if (!a->head->node_info.priced_in)
+    {
+    /*
+    Matching arc is priced out.
+    */
+    price_in_mch_arc(v, a);
 #if	defined(QUICK_MIN) && !defined(BACK_PRICE_OUT)
-	need_best_rebuild = TRUE;
+    need_best_rebuild = TRUE;
 #endif	/* QUICK_MIN && !BACK_PRICE_OUT */
-	}
-      }
-    else
+    }
+  }
+else
 #else	/* !STRONG_PO */
-    if (!one_priced_in)
+if (!one_priced_in)
 #endif	/* STRONG_PO */
-      if (a->head->node_info.priced_in)
-	{
-	/*
-	No arcs are priced in except the matching arc. Price it out,
-	too, and if we use back-arc price-outs, price out all the arcs
-	incident to its head.
-	*/
-	price_out_mch_arc(v, a);
+  if (a->head->node_info.priced_in)
+    {
+    /*
+    No arcs are priced in except the matching arc. Price it out,
+    too, and if we use back-arc price-outs, price out all the arcs
+    incident to its head.
+    */
+    price_out_mch_arc(v, a);
 #if	defined(QUICK_MIN) && !defined(BACK_PRICE_OUT)
-	need_best_rebuild = TRUE;
+    need_best_rebuild = TRUE;
 #endif	/* QUICK_MIN && !BACK_PRICE_OUT */
 #ifdef	BACK_PRICE_OUT
-	w = a->head;
-	b_stop = (w+1)->priced_out;
-	for (b = w->back_arcs; b != b_stop; b++)
-	  {
-	  u = b->tail;
-	  a = b->rev;
-	  price_out_unm_arc(u, a);
-	  }
-#endif	/* BACK_PRICE_OUT */
-	}
-#if	defined(QUICK_MIN) && !defined(BACK_PRICE_OUT)
-    /*
-    Make sure v->node_info.few_arcs reflects the priced-in degree of v.
-    */
-    if (a_stop - v->first < NUM_BEST + 1)
-      v->node_info.few_arcs = TRUE;
-    else
+    w = a->head;
+    b_stop = (w+1)->priced_out;
+    for (b = w->back_arcs; b != b_stop; b++)
       {
-      v->node_info.few_arcs = FALSE;
-      if (need_best_rebuild)
-	best_build(v);
+      u = b->tail;
+      a = b->rev;
+      price_out_unm_arc(u, a);
       }
+#endif	/* BACK_PRICE_OUT */
+    }
+#if	defined(QUICK_MIN) && !defined(BACK_PRICE_OUT)
+/*
+Make sure v->node_info.few_arcs reflects the priced-in degree of v.
+*/
+if (a_stop - v->first < NUM_BEST + 1)
+  v->node_info.few_arcs = TRUE;
+else
+  {
+  v->node_info.few_arcs = FALSE;
+  if (need_best_rebuild)
+    best_build(v);
+  }
 #endif	/* QUICK_MIN && !BACK_PRICE_OUT */
 #endif	/* USE_PRICE_OUT */
-    }
+return(fix_in);
+}
+
+#if	(defined(QUICK_MIN) && defined(BACK_PRICE_OUT)) || \
+	(defined(USE_PRICE_OUT) && defined(DEGREE_KERNELS))
+/*
+The work done for each lhs node after all price-ins and price-outs
+are through.
+*/
+
+static	void	finish_node(v)
+
+lhs_ptr	v;
+
+{
 #if	defined(QUICK_MIN) && defined(BACK_PRICE_OUT)
-  /*
-  Rebuild the best list for every node, since back price outs mean we
-  can't build them as we do the price outs.
-  */
+/*
+Rebuild the best list for every node, since back price outs mean we
+can't build them as we do the price outs.
+*/
+if ((v+1)->priced_out - v->first < NUM_BEST + 1)
+  v->node_info.few_arcs = TRUE;
+else
+  {
+  v->node_info.few_arcs = FALSE;
+  best_build(v);
+  }
+#endif
+#if	defined(USE_PRICE_OUT) && defined(DEGREE_KERNELS)
+/*
+Price-outs (including back-arc price-outs, which touch nodes other
+than the one being examined) and price-ins may have moved nodes
+between degree classes.
+*/
+set_deg_class(v);
+#endif
+}
+#endif
+#endif	/* USE_PRICE_OUT || CHECK_EPS_OPT */
+
+#ifdef	PAR_UPDATE_EPS
+static	void	update_thread(id)
+
+unsigned	id;
+
+{
+lhs_ptr	v, v_stop;
+int	my_fix_in = FALSE;
+
+while ((v = par_claim_lhs(&v_stop)) != NULL)
+  for (; v != v_stop; v++)
+    if (update_node(v))
+      my_fix_in = TRUE;
+if (my_fix_in)
+  fix_in = TRUE;
+par_fold_counts(id);
+}
+#endif	/* PAR_UPDATE_EPS */
+
+#if	(defined(PAR_UPDATE_EPS) || defined(PAR_BEST_BUILD)) && \
+	((defined(QUICK_MIN) && defined(BACK_PRICE_OUT)) || \
+	 (defined(USE_PRICE_OUT) && defined(DEGREE_KERNELS)))
+#define	PAR_FINISH
+#ifndef	PAR_UPDATE_EPS
+extern	void		par_run(), par_fold_counts();
+#endif
+#ifdef	PAR_BEST_BUILD
+extern	lhs_ptr		par_own_lhs();
+#endif
+
+/*
+Under PAR_BEST_BUILD each thread finishes a fixed run of nodes, so the
+best-list rebuilds sweep memory in long sequential runs; otherwise the
+nodes are claimed a run at a time.
+*/
+
+static	void	finish_thread(id)
+
+unsigned	id;
+
+{
+lhs_ptr	v, v_stop;
+
+#ifdef	PAR_BEST_BUILD
+for (v = par_own_lhs(id, &v_stop); v != v_stop; v++)
+  finish_node(v);
+#else
+while ((v = par_claim_lhs(&v_stop)) != NULL)
+  for (; v != v_stop; v++)
+    finish_node(v);
+#endif
+par_fold_counts(id);
+}
+#endif	/* PAR_FINISH */
+
+#ifdef	PIPELINE_EPS
+/*
+Update lhs nodes v, ..., v_stop - 1 for the current epsilon. In the
+PIPELINE_EPS case refine() calls this a block at a time instead of
+update_epsilon() doing every node at once.
+*/
+
+void	update_block(v, v_stop)
+
+lhs_ptr	v, v_stop;
+
+{
+for (; v != v_stop; v++)
+  {
+  (void) update_node(v);
+#if	(defined(QUICK_MIN) && defined(BACK_PRICE_OUT)) || \
+	(defined(USE_PRICE_OUT) && defined(DEGREE_KERNELS))
+  finish_node(v);
+#endif
+  }
+}
+#endif
+
+int	update_epsilon()
+
+{
+#if	(defined(USE_PRICE_OUT) || defined(CHECK_EPS_OPT)) && \
+	!defined(PIPELINE_EPS) && !defined(PAR_UPDATE_EPS)
+lhs_ptr	v;
+#endif
+extern	double	scale_factor;
+
+#ifndef	PAR_UPDATE_EPS
+int	fix_in = FALSE;
+#endif
+
+#ifdef	ADAPTIVE_EPS
+epsilon /= adapt_divisor();
+#else
+epsilon /= scale_factor;
+#endif
+
+if (epsilon < min_epsilon) epsilon = min_epsilon;
+
+#ifdef	USE_PRICE_OUT
+po_cutoff = po_cost_thresh * epsilon;
+#endif
+
+#ifdef	PAR_UPDATE_EPS
+fix_in = FALSE;
+#endif
+/*
+In the PIPELINE_EPS case, refine() does the following a block at a
+time, by way of update_block().
+*/
+#if	(defined(USE_PRICE_OUT) || defined(CHECK_EPS_OPT)) && \
+	!defined(PIPELINE_EPS)
+/*
+Now if at least one refine has occurred (and hence all lhs nodes are
+matched), check for arcs that should be priced in and price them in,
+and check for arcs that should be priced out and price them out.
+*/
+if (refines > 0)
+  {
+#ifdef	PAR_UPDATE_EPS
+#ifdef	STORE_REV_ARCS
+  par_rev_init();
+#endif
+  par_run(update_thread);
+#ifdef	STORE_REV_ARCS
+  par_rev_moves();
+#endif
+#else	/* PAR_UPDATE_EPS */
   for (v = head_lhs_node; v != tail_lhs_node; v++)
-    if ((v+1)->priced_out - v->first < NUM_BEST + 1)
-      v->node_info.few_arcs = TRUE;
-    else
-      {
-      v->node_info.few_arcs = FALSE;
-      best_build(v);
-      }
+    if (update_node(v))
+      fix_in = TRUE;
+#endif	/* PAR_UPDATE_EPS */
+#if	defined(PAR_FINISH)
+  par_run(finish_thread);
+#elif	(defined(QUICK_MIN) && defined(BACK_PRICE_OUT)) || \
+	(defined(USE_PRICE_OUT) && defined(DEGREE_KERNELS))
+  for (v = head_lhs_node; v != tail_lhs_node; v++)
+    finish_node(v);
 #endif
   }
-#endif	/* USE_PRICE_OUT || CHECK_EPS_OPT */
+#endif	/* (USE_PRICE_OUT || CHECK_EPS_OPT) && !PIPELINE_EPS */
 return(!fix_in);
 }
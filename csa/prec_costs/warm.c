@@ -0,0 +1,203 @@
+#include	<stdio.h>
+#include	"csa_types.h"
+#include	"csa_defs.h"
+
+/*
+Warm start from the prices, and optionally the matching, of an earlier
+run, typically on a slightly different instance. The prices are read
+from WARM_DUAL and the matching from WARM_FLOW, both in the current
+directory, in the formats display_results() writes to output.dual and
+output.flow, so a run can be chained to the one before it by renaming
+those. Node numbers are the solver's own, as in output.flow.
+
+Nodes missing from the price file keep price zero, and matching arcs
+that no longer exist, or whose rhs node has already been taken, are
+dropped. The remaining matching arcs certify that the imported prices
+are epsilon-optimal for epsilon the largest amount by which a matching
+arc's partial reduced cost exceeds the smallest among its node's other
+arcs, and cost scaling starts from that epsilon rather than from the
+largest cost. The first refine keeps every imported matching arc that
+is still epsilon-optimal, so only the nodes around the violated ones
+are repaired. Without a matching we build one greedily from the prices
+(see greedy_match()) and treat it the same way.
+*/
+
+#define	WARM_DUAL	"warm.dual"
+#define	WARM_FLOW	"warm.flow"
+
+extern	unsigned	n;
+extern	lhs_ptr		head_lhs_node, tail_lhs_node;
+extern	rhs_ptr		head_rhs_node, tail_rhs_node;
+extern	double		scale_factor;
+extern	double		match_gap();
+extern	int		match_holds();
+
+static	int	warmed = FALSE;		/* was anything imported? */
+static	unsigned	started = 0,	/* matching arcs we start with */
+			kept = 0;	/* and kept by the first refine */
+static	double	start_eps;
+
+static	void	read_dual()
+
+{
+FILE	*f;
+char	line[128];
+unsigned long	id, lhs_n = tail_lhs_node - head_lhs_node,
+		rhs_n = tail_rhs_node - head_rhs_node;
+double	p;
+
+if ((f = fopen(WARM_DUAL, "r")) == NULL)
+  return;
+warmed = TRUE;
+while (fgets(line, sizeof(line), f))
+  if ((sscanf(line, "n %lu %lg", &id, &p) == 2) &&
+      (id > lhs_n) && (id <= lhs_n + rhs_n))
+    head_rhs_node[id - lhs_n - 1].p = p;
+(void) fclose(f);
+}
+
+static	void	read_flow()
+
+{
+FILE	*f;
+char	line[128];
+unsigned long	v_id, w_id, lhs_n = tail_lhs_node - head_lhs_node,
+		rhs_n = tail_rhs_node - head_rhs_node;
+lhs_ptr	v;
+rhs_ptr	w;
+lr_aptr	a, a_stop;
+
+if ((f = fopen(WARM_FLOW, "r")) == NULL)
+  return;
+warmed = TRUE;
+while (fgets(line, sizeof(line), f))
+  {
+  if ((sscanf(line, "f %lu %lu", &v_id, &w_id) != 2) ||
+      (v_id == 0) || (v_id > lhs_n) ||
+      (w_id <= lhs_n) || (w_id > lhs_n + rhs_n))
+    continue;
+  v = head_lhs_node + v_id - 1;
+  w = head_rhs_node + w_id - lhs_n - 1;
+  if (v->matched || w->matched)
+    continue;
+  a_stop = (v + 1)->priced_out;
+  for (a = v->first; (a != a_stop) && (a->head != w); a++) ;
+  if (a != a_stop)
+    {
+    v->matched = a;
+    w->matched = v;
+    started++;
+    }
+  }
+(void) fclose(f);
+}
+
+/*
+Without an imported matching, match each lhs node in turn along its
+arc of least partial reduced cost to an rhs node not yet taken. How
+far the prices are from optimal shows in how much the later nodes
+lose to the earlier ones.
+*/
+
+static	void	greedy_match()
+
+{
+lhs_ptr	v;
+lr_aptr	a, a_stop, best;
+
+for (v = head_lhs_node; v != tail_lhs_node; v++)
+  {
+  best = NULL;
+  a_stop = (v + 1)->priced_out;
+  for (a = v->first; a != a_stop; a++)
+    if ((a->head->matched == NULL) &&
+	((best == NULL) || (a->c - a->head->p < best->c - best->head->p)))
+      best = a;
+  if (best)
+    {
+    v->matched = best;
+    best->head->matched = v;
+    started++;
+    }
+  }
+}
+
+/*
+Import what there is, and return the epsilon from which to scale:
+max_cost if there is nothing, and otherwise the smallest value for
+which the imported matching certifies the prices, but large enough
+that at least one refine completes the matching.
+*/
+
+double	warm_start(max_cost)
+
+double	max_cost;
+
+{
+lhs_ptr	v;
+double	gap, floor_eps;
+
+read_dual();
+read_flow();
+if (!warmed)
+  return(max_cost);
+if (started == 0)
+  greedy_match();
+
+start_eps = 0.0;
+for (v = head_lhs_node; v != tail_lhs_node; v++)
+  if (v->matched && ((gap = match_gap(v)) > start_eps))
+    start_eps = gap;
+if (start_eps > max_cost)
+  start_eps = max_cost;
+/*
+Any epsilon strictly between the min_epsilon solve() sets and
+scale_factor times it leads to exactly one refine, at min_epsilon.
+*/
+floor_eps = 2.0 / (double) (n + 1) * (1.0 + scale_factor) / 2.0;
+if (start_eps < floor_eps)
+  start_eps = floor_eps;
+return(start_eps);
+}
+
+/*
+Whether the first refine may keep v's imported matching arc.
+*/
+
+int	warm_keep(v)
+
+lhs_ptr	v;
+
+{
+if (!match_holds(v))
+  return(FALSE);
+kept++;
+return(TRUE);
+}
+
+/*
+Write the prices of the rhs nodes where warm_start() will find them
+once renamed.
+*/
+
+void	write_dual()
+
+{
+FILE	*f;
+rhs_ptr	w;
+unsigned long	lhs_n = tail_lhs_node - head_lhs_node;
+
+if ((f = fopen("output.dual", "w")) == NULL)
+  return;
+for (w = head_rhs_node; w != tail_rhs_node; w++)
+  (void) fprintf(f, "n %lu %.17lg\n", w - head_rhs_node + 1 + lhs_n, w->p);
+(void) fclose(f);
+}
+
+void	display_warm()
+
+{
+if (warmed)
+  (void) printf("|>   warm start at epsilon %lg; %u of %u matching arcs kept\n",
+		start_eps, kept, started);
+}
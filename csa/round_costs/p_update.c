@@ -166,7 +166,7 @@ for (w = head_rhs_node; w != tail_rhs_node; w++)
     insert_list(w, &bucket[0]);
     }
 
-balance = -total_e;
+balance = -(long) total_e;
 level = 0;
 
 while ((balance < 0) && (level < num_buckets))
@@ -1,11 +1,40 @@
 #include	<sys/types.h>
 #include	<sys/times.h>
+#include	"csa_types.h"
 
 unsigned	myclock()
 
 {
 struct tms hold;
 
+#ifdef	USE_THREADS
+/*
+User time adds up over all threads, and leaves out that of forked
+processes, so report elapsed time instead.
+*/
+return((unsigned) times(&hold));
+#else
 (void) times(&hold);
 return(hold.tms_utime);
+#endif
 }
+
+#if	defined(DEGREE_STATS) || defined(WORK_STEALING) || \
+	defined(PIPELINE_EPS) || defined(INCREMENTAL) || defined(ANYTIME) || \
+	defined(INIT_MATCH) || defined(DENSE_JV) || defined(PAR_P_UPDATE)
+#include	<sys/time.h>
+
+/*
+Wall-clock time in seconds, fine-grained enough to time individual
+double pushes.
+*/
+
+double	fine_clock()
+
+{
+struct timeval hold;
+
+(void) gettimeofday(&hold, (struct timezone *) 0);
+return((double) hold.tv_sec + (double) hold.tv_usec / 1e6);
+}
+#endif